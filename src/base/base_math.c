@@ -42,6 +42,116 @@ b32 rectf_collide_circlef(rectf rect, circlef circle) {
     return false;
 }
 
+b32 rectf_collide_capsulef(rectf rect, capsulef capsule) {
+    // The closest points of a segment and a rect are either an end point of the segment,
+    // a corner of the rect, or the segment goes through the rect
+    if (rectf_collide_circlef(rect, (circlef){ capsule.p0, capsule.r }) ||
+        rectf_collide_circlef(rect, (circlef){ capsule.p1, capsule.r })) {
+        return true;
+    }
+
+    vec2f l = vec2f_sub(capsule.p1, capsule.p0);
+    f32 sqr_len = vec2f_sqr_len(l);
+
+    vec2f corners[4] = {
+        { rect.x, rect.y },
+        { rect.x + rect.w, rect.y },
+        { rect.x, rect.y + rect.h },
+        { rect.x + rect.w, rect.y + rect.h },
+    };
+
+    for (u32 i = 0; i < 4; i++) {
+        vec2f d = vec2f_sub(corners[i], capsule.p0);
+        f32 t = sqr_len > 0.0f ? vec2f_dot(d, l) / sqr_len : 0.0f;
+        t = CLAMP(t, 0.0f, 1.0f);
+
+        if (vec2f_sqr_len(vec2f_sub(d, vec2f_scl(l, t))) <= capsule.r * capsule.r) {
+            return true;
+        }
+    }
+
+    // Clipping the segment against both slabs of the rect
+    f32 t_min = 0.0f;
+    f32 t_max = 1.0f;
+
+    f32 starts[2] = { capsule.p0.x, capsule.p0.y };
+    f32 dirs[2] = { l.x, l.y };
+    f32 mins[2] = { rect.x, rect.y };
+    f32 maxs[2] = { rect.x + rect.w, rect.y + rect.h };
+
+    for (u32 i = 0; i < 2; i++) {
+        if (dirs[i] == 0.0f) {
+            if (starts[i] < mins[i] || starts[i] > maxs[i]) {
+                return false;
+            }
+
+            continue;
+        }
+
+        f32 t0 = (mins[i] - starts[i]) / dirs[i];
+        f32 t1 = (maxs[i] - starts[i]) / dirs[i];
+
+        t_min = MAX(t_min, MIN(t0, t1));
+        t_max = MIN(t_max, MAX(t0, t1));
+    }
+
+    return t_min <= t_max;
+}
+rectf rectf_union(rectf a, rectf b) {
+    f32 min_x = MIN(a.x, b.x);
+    f32 min_y = MIN(a.y, b.y);
+    f32 max_x = MAX(a.x + a.w, b.x + b.w);
+    f32 max_y = MAX(a.y + a.h, b.y + b.h);
+
+    return (rectf){ min_x, min_y, max_x - min_x, max_y - min_y };
+}
+rectf capsulef_bounds(capsulef capsule) {
+    f32 min_x = MIN(capsule.p0.x, capsule.p1.x);
+    f32 min_y = MIN(capsule.p0.y, capsule.p1.y);
+    f32 max_x = MAX(capsule.p0.x, capsule.p1.x);
+    f32 max_y = MAX(capsule.p0.y, capsule.p1.y);
+
+    return (rectf){
+        min_x - capsule.r,
+        min_y - capsule.r,
+        (max_x - min_x) + capsule.r * 2.0f,
+        (max_y - min_y) + capsule.r * 2.0f
+    };
+}
+rectf viewf_bounds(viewf view) {
+    f32 half_w = view.width * 0.5f;
+    f32 half_h = view.width / view.aspect_ratio * 0.5f;
+
+    f32 r_sin = fabsf(sinf(view.rotation));
+    f32 r_cos = fabsf(cosf(view.rotation));
+
+    // Half extents of the rotated rect
+    f32 ext_x = half_w * r_cos + half_h * r_sin;
+    f32 ext_y = half_w * r_sin + half_h * r_cos;
+
+    return (rectf){
+        view.center.x - ext_x,
+        view.center.y - ext_y,
+        ext_x * 2.0f,
+        ext_y * 2.0f
+    };
+}
+vec2f viewf_ndc_to_world(viewf view, vec2f ndc) {
+    // Undoes mat3f_from_view, world y points down
+    vec2f d = {
+        ndc.x * view.width * 0.5f,
+        -ndc.y * view.width / view.aspect_ratio * 0.5f
+    };
+
+    f32 r_sin = sinf(view.rotation);
+    f32 r_cos = cosf(view.rotation);
+
+    return (vec2f){
+        view.center.x + r_cos * d.x - r_sin * d.y,
+        view.center.y + r_sin * d.x + r_cos * d.y
+    };
+}
+
 vec2f vec2f_add(vec2f a, vec2f b) {
     return (vec2f){ a.x + b.x, a.y + b.y };
 }
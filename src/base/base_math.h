@@ -10,6 +10,8 @@ typedef struct { f32 x, y, z, w; } vec4f;
 typedef struct { f32 x, y, w, h; } rectf;
 
 typedef struct { vec2f pos; f32 r; } circlef;
+// Every point closer than r to the segment p0 -> p1
+typedef struct { vec2f p0, p1; f32 r; } capsulef;
 
 typedef struct { f32 m[4];  } mat2f;
 typedef struct { f32 m[9];  } mat3f;
@@ -30,6 +32,15 @@ typedef struct {
 b32 vec2f_in_rectf(vec2f point, rectf rect);
 b32 rectf_collide_rectf(rectf a, rectf b);
 b32 rectf_collide_circlef(rectf rect, circlef circle);
+b32 rectf_collide_capsulef(rectf rect, capsulef capsule);
+// Smallest rect that contains both rects
+rectf rectf_union(rectf a, rectf b);
+// Smallest rect that contains the capsule
+rectf capsulef_bounds(capsulef capsule);
+// Smallest world space rect that contains everything the view shows, rotated views included
+rectf viewf_bounds(viewf view);
+// Point of the world under ndc, without mat3f_inverse, which fails for views zoomed far out
+vec2f viewf_ndc_to_world(viewf view, vec2f ndc);
 
 vec2f vec2f_add(vec2f a, vec2f b);
 vec2f vec2f_sub(vec2f a, vec2f b);
@@ -4,12 +4,38 @@
 draw_lines *draw_lines_clone(mg_arena *arena, draw_lines *src)
 {
     draw_lines *dst = draw_lines_create(arena, src->allocator, src->color, src->width);
-    draw_point_bucket *bucket = src->points.first;
-    while (bucket) {
-        for (u32 i = 0; i < bucket->size; i++) {
-            draw_lines_add_point(dst, bucket->points[i]);
-        }
-        bucket = bucket->next;
+    for (u32 i = 0; i < src->points.size; i++) {
+        draw_lines_add_point(dst, draw_point_list_get(&src->points, i));
     }
+    if (src->points.sealed) {
+        draw_lines_seal(dst);
+    }
+    return dst;
+}
+
+draw_lines *draw_lines_simplify(mg_arena *arena, draw_lines *src, f32 tolerance)
+{
+    if (src == NULL || src->points.size == 0) {
+        return NULL;
+    }
+    mga_temp scratch = mga_scratch_get(NULL, 0);
+    u32 num_points = src->points.size;
+    vec2f *points = MGA_PUSH_ARRAY(scratch.arena, vec2f, num_points);
+    vec2f *simplified = MGA_PUSH_ARRAY(scratch.arena, vec2f, num_points);
+    draw_point_list_copy(&src->points, points);
+    u32 num_simplified = draw_simplify_points(points, num_points, tolerance, simplified);
+    draw_lines *dst = draw_lines_from_points(arena, src->allocator, simplified, num_simplified, src->color, src->width);
+    mga_scratch_release(scratch);
     return dst;
-}
\ No newline at end of file
+}
+
+void draw_lines_seal(draw_lines *lines)
+{
+    if (lines == NULL || lines->points.size == 0) {
+        return;
+    }
+    if (lines->batch == NULL) {
+        draw_lines_build_lods(lines);
+    }
+    draw_point_list_seal(&lines->points, lines->width * DRAW_LINES_SEAL_PRECISION);
+}
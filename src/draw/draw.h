@@ -7,8 +7,25 @@
 
 #include "draw_lines.h"
 #include "draw_point_bucket.h"
+#include "draw_index.h"
+#include "draw_batch.h"
+#include "draw_stream.h"
+#include "draw_tiles.h"
+#include "draw_overview.h"
+#include "draw_reproject.h"
+#include "draw_collide.h"
+#include "draw_simplify.h"
+
+// Sealed points are rounded to this fraction of the line width
+#define DRAW_LINES_SEAL_PRECISION (1.0f / 256.0f)
 
 draw_lines *draw_lines_clone(mg_arena *arena, draw_lines *src);
+// Creates new lines from the simplified points of src, see draw_simplify_points
+draw_lines *draw_lines_simplify(mg_arena *arena, draw_lines *src, f32 tolerance);
+// Switches finished lines to the compressed point storage and builds their zoomed out geometry,
+// new points cannot be added after. Clearing the lines makes them writable again.
+// Batched lines skip the zoomed out geometry, the batch has its own
+void draw_lines_seal(draw_lines *lines);
 
 #endif // DRAW_H
 
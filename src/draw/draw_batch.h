@@ -0,0 +1,49 @@
+#ifndef DRAW_BATCH_H
+#define DRAW_BATCH_H
+
+#include "base/base.h"
+#include "draw_lines.h"
+#include "gfx/gfx.h"
+
+// Contents defined in draw backends
+typedef struct draw_batch draw_batch;
+
+typedef struct {
+    // Lines drawn and lines skipped for being outside the view, in the last draw_batch_draw
+    u32 num_visible;
+    u32 num_culled;
+} draw_batch_stats;
+
+// Shared buffers for finished lines, with the color baked into the vertices.
+// Lines next to each other in the batch get drawn with a single call.
+// Where compute shaders are available the vertices get built on the GPU from the points
+draw_batch* draw_batch_create(mg_arena* arena);
+void draw_batch_destroy(draw_batch* batch);
+
+// Copies the geometry of the lines into the batch, together with its own zoomed out levels.
+// Lines cannot be in more than one batch, and leave it when they get cleared or destroyed
+void draw_batch_add(draw_batch* batch, draw_lines* lines);
+void draw_batch_remove(draw_batch* batch, draw_lines* lines);
+// Builds the geometry of lines in the batch again after their color or width changed.
+// With compute shaders this waits for the next draw and keeps the zoomed out levels as they are
+void draw_batch_update(draw_batch* batch, draw_lines* lines);
+
+// Draws the lines in order. Lines whose bounding box is outside the view are skipped before any GL calls.
+// Lines from this batch get merged into as few calls as possible, any other lines are drawn with draw_lines_draw in between.
+// With compute shaders the bounding boxes of the batch are tested on the GPU, which writes the indirect draw commands.
+// Those boxes are only uploaded again when lines join or leave the batch, or the lines array or its size changes
+void draw_batch_draw(
+    draw_batch* batch, draw_lines** lines, u32 num_lines,
+    const draw_lines_shaders* shaders, const gfx_window* win, viewf view
+);
+// With compute shaders this waits for the GPU to finish culling
+draw_batch_stats draw_batch_get_stats(const draw_batch* batch);
+
+// Number of lines in the batch
+u32 draw_batch_num_lines(const draw_batch* batch);
+
+// Once more than half of the batch belongs to lines that left it, the geometry is built again
+// with the lines in the order given, so that neighbours draw together again
+void draw_batch_maybe_compact(draw_batch* batch, draw_lines** lines, u32 num_lines);
+
+#endif // DRAW_BATCH_H
@@ -0,0 +1,441 @@
+#include "draw_collide.h"
+
+#if defined(__AVX2__)
+#    define DRAW_COLLIDE_AVX2
+#    include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define DRAW_COLLIDE_SSE2
+#    include <emmintrin.h>
+#endif
+
+// For a segment p0 -> p1 and a circle center c, with p = c - p0 and l = p1 - p0:
+// the closest point is an endpoint when dot(p, l) is outside of (0, |l|^2),
+// otherwise the distance is cross(p, l) / |l|. Comparing cross^2 against r^2 * |l|^2
+// avoids the division and the endpoint tests avoid any special case for zero length segments
+
+static b32 _segment_collide_scalar(vec2f p0, vec2f p1, vec2f pos, f32 sqr_radius) {
+    f32 lx = p1.x - p0.x;
+    f32 ly = p1.y - p0.y;
+    f32 px = pos.x - p0.x;
+    f32 py = pos.y - p0.y;
+    f32 qx = px - lx;
+    f32 qy = py - ly;
+
+    f32 dot = px * lx + py * ly;
+    f32 sqr_len = lx * lx + ly * ly;
+    f32 crs = px * ly - py * lx;
+
+    b32 mid_hit = dot > 0.0f && dot < sqr_len && crs * crs < sqr_radius * sqr_len;
+    b32 end_hit = (px * px + py * py) < sqr_radius || (qx * qx + qy * qy) < sqr_radius;
+
+    return mid_hit || end_hit;
+}
+
+// Two segments are closer than the radius if an end point of one is close to the other,
+// or if they cross. The crossing test uses the signs of the cross products
+static b32 _segment_collide_capsule_scalar(vec2f p0, vec2f p1, vec2f c0, vec2f c1, f32 sqr_radius) {
+    if (_segment_collide_scalar(p0, p1, c0, sqr_radius) || _segment_collide_scalar(p0, p1, c1, sqr_radius) ||
+        _segment_collide_scalar(c0, c1, p0, sqr_radius) || _segment_collide_scalar(c0, c1, p1, sqr_radius)) {
+        return true;
+    }
+
+    vec2f l = vec2f_sub(p1, p0);
+    vec2f q = vec2f_sub(c1, c0);
+
+    f32 d0 = vec2f_crs(l, vec2f_sub(c0, p0));
+    f32 d1 = vec2f_crs(l, vec2f_sub(c1, p0));
+    f32 d2 = vec2f_crs(q, vec2f_sub(p0, c0));
+    f32 d3 = vec2f_crs(q, vec2f_sub(p1, c0));
+
+    return d0 * d1 < 0.0f && d2 * d3 < 0.0f;
+}
+
+#if defined(DRAW_COLLIDE_AVX2)
+
+// Splits eight interleaved points into x and y registers
+static void _load_points8(const vec2f* points, __m256* xs, __m256* ys) {
+    __m256 a = _mm256_loadu_ps(&points[0].x);
+    __m256 b = _mm256_loadu_ps(&points[4].x);
+
+    // The shuffles work per 128 bit lane, so the halves need to be reordered after
+    __m256 x = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+    __m256 y = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+
+    *xs = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(x), _MM_SHUFFLE(3, 1, 2, 0)));
+    *ys = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(y), _MM_SHUFFLE(3, 1, 2, 0)));
+}
+
+// Lanes are all ones for the segments closer than the radius
+static __m256 _segments_hit8(__m256 x0, __m256 y0, __m256 x1, __m256 y1, __m256 cx, __m256 cy, __m256 sqr_r, __m256 zero) {
+    __m256 lx = _mm256_sub_ps(x1, x0);
+    __m256 ly = _mm256_sub_ps(y1, y0);
+    __m256 px = _mm256_sub_ps(cx, x0);
+    __m256 py = _mm256_sub_ps(cy, y0);
+    __m256 qx = _mm256_sub_ps(px, lx);
+    __m256 qy = _mm256_sub_ps(py, ly);
+
+    __m256 dot = _mm256_add_ps(_mm256_mul_ps(px, lx), _mm256_mul_ps(py, ly));
+    __m256 sqr_len = _mm256_add_ps(_mm256_mul_ps(lx, lx), _mm256_mul_ps(ly, ly));
+    __m256 crs = _mm256_sub_ps(_mm256_mul_ps(px, ly), _mm256_mul_ps(py, lx));
+
+    __m256 mid_hit = _mm256_and_ps(
+        _mm256_and_ps(_mm256_cmp_ps(dot, zero, _CMP_GT_OQ), _mm256_cmp_ps(dot, sqr_len, _CMP_LT_OQ)),
+        _mm256_cmp_ps(_mm256_mul_ps(crs, crs), _mm256_mul_ps(sqr_r, sqr_len), _CMP_LT_OQ)
+    );
+
+    __m256 p_sqr = _mm256_add_ps(_mm256_mul_ps(px, px), _mm256_mul_ps(py, py));
+    __m256 q_sqr = _mm256_add_ps(_mm256_mul_ps(qx, qx), _mm256_mul_ps(qy, qy));
+    __m256 end_hit = _mm256_or_ps(_mm256_cmp_ps(p_sqr, sqr_r, _CMP_LT_OQ), _mm256_cmp_ps(q_sqr, sqr_r, _CMP_LT_OQ));
+
+    return _mm256_or_ps(mid_hit, end_hit);
+}
+
+// Lanes are all ones for the segments closer than the radius to the segment c0 -> c1
+static __m256 _segments_hit_capsule8(
+    __m256 x0, __m256 y0, __m256 x1, __m256 y1,
+    __m256 c0x, __m256 c0y, __m256 c1x, __m256 c1y, __m256 sqr_r, __m256 zero
+) {
+    __m256 hit = _mm256_or_ps(
+        _mm256_or_ps(
+            _segments_hit8(x0, y0, x1, y1, c0x, c0y, sqr_r, zero),
+            _segments_hit8(x0, y0, x1, y1, c1x, c1y, sqr_r, zero)
+        ),
+        _mm256_or_ps(
+            _segments_hit8(c0x, c0y, c1x, c1y, x0, y0, sqr_r, zero),
+            _segments_hit8(c0x, c0y, c1x, c1y, x1, y1, sqr_r, zero)
+        )
+    );
+
+    __m256 lx = _mm256_sub_ps(x1, x0);
+    __m256 ly = _mm256_sub_ps(y1, y0);
+    __m256 qx = _mm256_sub_ps(c1x, c0x);
+    __m256 qy = _mm256_sub_ps(c1y, c0y);
+
+    __m256 d0 = _mm256_sub_ps(_mm256_mul_ps(lx, _mm256_sub_ps(c0y, y0)), _mm256_mul_ps(ly, _mm256_sub_ps(c0x, x0)));
+    __m256 d1 = _mm256_sub_ps(_mm256_mul_ps(lx, _mm256_sub_ps(c1y, y0)), _mm256_mul_ps(ly, _mm256_sub_ps(c1x, x0)));
+    __m256 d2 = _mm256_sub_ps(_mm256_mul_ps(qx, _mm256_sub_ps(y0, c0y)), _mm256_mul_ps(qy, _mm256_sub_ps(x0, c0x)));
+    __m256 d3 = _mm256_sub_ps(_mm256_mul_ps(qx, _mm256_sub_ps(y1, c0y)), _mm256_mul_ps(qy, _mm256_sub_ps(x1, c0x)));
+
+    __m256 cross = _mm256_and_ps(
+        _mm256_cmp_ps(_mm256_mul_ps(d0, d1), zero, _CMP_LT_OQ),
+        _mm256_cmp_ps(_mm256_mul_ps(d2, d3), zero, _CMP_LT_OQ)
+    );
+
+    return _mm256_or_ps(hit, cross);
+}
+
+b32 draw_segments_collide_circle(const vec2f* points, u32 num_points, vec2f pos, f32 radius) {
+    if (points == NULL || num_points < 2) {
+        return false;
+    }
+
+    f32 sqr_radius = radius * radius;
+
+    __m256 cx = _mm256_set1_ps(pos.x);
+    __m256 cy = _mm256_set1_ps(pos.y);
+    __m256 sqr_r = _mm256_set1_ps(sqr_radius);
+    __m256 zero = _mm256_setzero_ps();
+
+    u32 i = 0;
+    // Eight segments need nine points
+    for (; i + 8 < num_points; i += 8) {
+        __m256 x0, y0, x1, y1;
+        _load_points8(points + i, &x0, &y0);
+        _load_points8(points + i + 1, &x1, &y1);
+
+        if (_mm256_movemask_ps(_segments_hit8(x0, y0, x1, y1, cx, cy, sqr_r, zero)) != 0) {
+            return true;
+        }
+    }
+
+    for (; i + 1 < num_points; i++) {
+        if (_segment_collide_scalar(points[i], points[i + 1], pos, sqr_radius)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+b32 draw_segments_collide_capsule(const vec2f* points, u32 num_points, vec2f p0, vec2f p1, f32 radius) {
+    if (points == NULL || num_points < 2) {
+        return false;
+    }
+
+    f32 sqr_radius = radius * radius;
+
+    __m256 c0x = _mm256_set1_ps(p0.x);
+    __m256 c0y = _mm256_set1_ps(p0.y);
+    __m256 c1x = _mm256_set1_ps(p1.x);
+    __m256 c1y = _mm256_set1_ps(p1.y);
+    __m256 sqr_r = _mm256_set1_ps(sqr_radius);
+    __m256 zero = _mm256_setzero_ps();
+
+    u32 i = 0;
+    for (; i + 8 < num_points; i += 8) {
+        __m256 x0, y0, x1, y1;
+        _load_points8(points + i, &x0, &y0);
+        _load_points8(points + i + 1, &x1, &y1);
+
+        if (_mm256_movemask_ps(_segments_hit_capsule8(x0, y0, x1, y1, c0x, c0y, c1x, c1y, sqr_r, zero)) != 0) {
+            return true;
+        }
+    }
+
+    for (; i + 1 < num_points; i++) {
+        if (_segment_collide_capsule_scalar(points[i], points[i + 1], p0, p1, sqr_radius)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void draw_segments_hit_capsule(const vec2f* points, u32 num_points, vec2f p0, vec2f p1, f32 radius, b8* hits) {
+    if (points == NULL || hits == NULL || num_points < 2) {
+        return;
+    }
+
+    f32 sqr_radius = radius * radius;
+
+    __m256 c0x = _mm256_set1_ps(p0.x);
+    __m256 c0y = _mm256_set1_ps(p0.y);
+    __m256 c1x = _mm256_set1_ps(p1.x);
+    __m256 c1y = _mm256_set1_ps(p1.y);
+    __m256 sqr_r = _mm256_set1_ps(sqr_radius);
+    __m256 zero = _mm256_setzero_ps();
+
+    u32 i = 0;
+    for (; i + 8 < num_points; i += 8) {
+        __m256 x0, y0, x1, y1;
+        _load_points8(points + i, &x0, &y0);
+        _load_points8(points + i + 1, &x1, &y1);
+
+        u32 mask = (u32)_mm256_movemask_ps(_segments_hit_capsule8(x0, y0, x1, y1, c0x, c0y, c1x, c1y, sqr_r, zero));
+
+        for (u32 j = 0; j < 8; j++) {
+            hits[i + j] = (mask >> j) & 1;
+        }
+    }
+
+    for (; i + 1 < num_points; i++) {
+        hits[i] = _segment_collide_capsule_scalar(points[i], points[i + 1], p0, p1, sqr_radius);
+    }
+}
+
+#elif defined(DRAW_COLLIDE_SSE2)
+
+// Splits four interleaved points into x and y registers
+static void _load_points4(const vec2f* points, __m128* xs, __m128* ys) {
+    __m128 a = _mm_loadu_ps(&points[0].x);
+    __m128 b = _mm_loadu_ps(&points[2].x);
+
+    *xs = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+    *ys = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+}
+
+// Lanes are all ones for the segments closer than the radius
+static __m128 _segments_hit4(__m128 x0, __m128 y0, __m128 x1, __m128 y1, __m128 cx, __m128 cy, __m128 sqr_r, __m128 zero) {
+    __m128 lx = _mm_sub_ps(x1, x0);
+    __m128 ly = _mm_sub_ps(y1, y0);
+    __m128 px = _mm_sub_ps(cx, x0);
+    __m128 py = _mm_sub_ps(cy, y0);
+    __m128 qx = _mm_sub_ps(px, lx);
+    __m128 qy = _mm_sub_ps(py, ly);
+
+    __m128 dot = _mm_add_ps(_mm_mul_ps(px, lx), _mm_mul_ps(py, ly));
+    __m128 sqr_len = _mm_add_ps(_mm_mul_ps(lx, lx), _mm_mul_ps(ly, ly));
+    __m128 crs = _mm_sub_ps(_mm_mul_ps(px, ly), _mm_mul_ps(py, lx));
+
+    __m128 mid_hit = _mm_and_ps(
+        _mm_and_ps(_mm_cmpgt_ps(dot, zero), _mm_cmplt_ps(dot, sqr_len)),
+        _mm_cmplt_ps(_mm_mul_ps(crs, crs), _mm_mul_ps(sqr_r, sqr_len))
+    );
+
+    __m128 p_sqr = _mm_add_ps(_mm_mul_ps(px, px), _mm_mul_ps(py, py));
+    __m128 q_sqr = _mm_add_ps(_mm_mul_ps(qx, qx), _mm_mul_ps(qy, qy));
+    __m128 end_hit = _mm_or_ps(_mm_cmplt_ps(p_sqr, sqr_r), _mm_cmplt_ps(q_sqr, sqr_r));
+
+    return _mm_or_ps(mid_hit, end_hit);
+}
+
+// Lanes are all ones for the segments closer than the radius to the segment c0 -> c1
+static __m128 _segments_hit_capsule4(
+    __m128 x0, __m128 y0, __m128 x1, __m128 y1,
+    __m128 c0x, __m128 c0y, __m128 c1x, __m128 c1y, __m128 sqr_r, __m128 zero
+) {
+    __m128 hit = _mm_or_ps(
+        _mm_or_ps(
+            _segments_hit4(x0, y0, x1, y1, c0x, c0y, sqr_r, zero),
+            _segments_hit4(x0, y0, x1, y1, c1x, c1y, sqr_r, zero)
+        ),
+        _mm_or_ps(
+            _segments_hit4(c0x, c0y, c1x, c1y, x0, y0, sqr_r, zero),
+            _segments_hit4(c0x, c0y, c1x, c1y, x1, y1, sqr_r, zero)
+        )
+    );
+
+    __m128 lx = _mm_sub_ps(x1, x0);
+    __m128 ly = _mm_sub_ps(y1, y0);
+    __m128 qx = _mm_sub_ps(c1x, c0x);
+    __m128 qy = _mm_sub_ps(c1y, c0y);
+
+    __m128 d0 = _mm_sub_ps(_mm_mul_ps(lx, _mm_sub_ps(c0y, y0)), _mm_mul_ps(ly, _mm_sub_ps(c0x, x0)));
+    __m128 d1 = _mm_sub_ps(_mm_mul_ps(lx, _mm_sub_ps(c1y, y0)), _mm_mul_ps(ly, _mm_sub_ps(c1x, x0)));
+    __m128 d2 = _mm_sub_ps(_mm_mul_ps(qx, _mm_sub_ps(y0, c0y)), _mm_mul_ps(qy, _mm_sub_ps(x0, c0x)));
+    __m128 d3 = _mm_sub_ps(_mm_mul_ps(qx, _mm_sub_ps(y1, c0y)), _mm_mul_ps(qy, _mm_sub_ps(x1, c0x)));
+
+    __m128 cross = _mm_and_ps(
+        _mm_cmplt_ps(_mm_mul_ps(d0, d1), zero),
+        _mm_cmplt_ps(_mm_mul_ps(d2, d3), zero)
+    );
+
+    return _mm_or_ps(hit, cross);
+}
+
+b32 draw_segments_collide_circle(const vec2f* points, u32 num_points, vec2f pos, f32 radius) {
+    if (points == NULL || num_points < 2) {
+        return false;
+    }
+
+    f32 sqr_radius = radius * radius;
+
+    __m128 cx = _mm_set1_ps(pos.x);
+    __m128 cy = _mm_set1_ps(pos.y);
+    __m128 sqr_r = _mm_set1_ps(sqr_radius);
+    __m128 zero = _mm_setzero_ps();
+
+    u32 i = 0;
+    // Four segments need five points
+    for (; i + 4 < num_points; i += 4) {
+        __m128 x0, y0, x1, y1;
+        _load_points4(points + i, &x0, &y0);
+        _load_points4(points + i + 1, &x1, &y1);
+
+        if (_mm_movemask_ps(_segments_hit4(x0, y0, x1, y1, cx, cy, sqr_r, zero)) != 0) {
+            return true;
+        }
+    }
+
+    for (; i + 1 < num_points; i++) {
+        if (_segment_collide_scalar(points[i], points[i + 1], pos, sqr_radius)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+b32 draw_segments_collide_capsule(const vec2f* points, u32 num_points, vec2f p0, vec2f p1, f32 radius) {
+    if (points == NULL || num_points < 2) {
+        return false;
+    }
+
+    f32 sqr_radius = radius * radius;
+
+    __m128 c0x = _mm_set1_ps(p0.x);
+    __m128 c0y = _mm_set1_ps(p0.y);
+    __m128 c1x = _mm_set1_ps(p1.x);
+    __m128 c1y = _mm_set1_ps(p1.y);
+    __m128 sqr_r = _mm_set1_ps(sqr_radius);
+    __m128 zero = _mm_setzero_ps();
+
+    u32 i = 0;
+    for (; i + 4 < num_points; i += 4) {
+        __m128 x0, y0, x1, y1;
+        _load_points4(points + i, &x0, &y0);
+        _load_points4(points + i + 1, &x1, &y1);
+
+        if (_mm_movemask_ps(_segments_hit_capsule4(x0, y0, x1, y1, c0x, c0y, c1x, c1y, sqr_r, zero)) != 0) {
+            return true;
+        }
+    }
+
+    for (; i + 1 < num_points; i++) {
+        if (_segment_collide_capsule_scalar(points[i], points[i + 1], p0, p1, sqr_radius)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void draw_segments_hit_capsule(const vec2f* points, u32 num_points, vec2f p0, vec2f p1, f32 radius, b8* hits) {
+    if (points == NULL || hits == NULL || num_points < 2) {
+        return;
+    }
+
+    f32 sqr_radius = radius * radius;
+
+    __m128 c0x = _mm_set1_ps(p0.x);
+    __m128 c0y = _mm_set1_ps(p0.y);
+    __m128 c1x = _mm_set1_ps(p1.x);
+    __m128 c1y = _mm_set1_ps(p1.y);
+    __m128 sqr_r = _mm_set1_ps(sqr_radius);
+    __m128 zero = _mm_setzero_ps();
+
+    u32 i = 0;
+    for (; i + 4 < num_points; i += 4) {
+        __m128 x0, y0, x1, y1;
+        _load_points4(points + i, &x0, &y0);
+        _load_points4(points + i + 1, &x1, &y1);
+
+        u32 mask = (u32)_mm_movemask_ps(_segments_hit_capsule4(x0, y0, x1, y1, c0x, c0y, c1x, c1y, sqr_r, zero));
+
+        for (u32 j = 0; j < 4; j++) {
+            hits[i + j] = (mask >> j) & 1;
+        }
+    }
+
+    for (; i + 1 < num_points; i++) {
+        hits[i] = _segment_collide_capsule_scalar(points[i], points[i + 1], p0, p1, sqr_radius);
+    }
+}
+
+#else
+
+b32 draw_segments_collide_circle(const vec2f* points, u32 num_points, vec2f pos, f32 radius) {
+    if (points == NULL || num_points < 2) {
+        return false;
+    }
+
+    f32 sqr_radius = radius * radius;
+
+    for (u32 i = 0; i + 1 < num_points; i++) {
+        if (_segment_collide_scalar(points[i], points[i + 1], pos, sqr_radius)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+b32 draw_segments_collide_capsule(const vec2f* points, u32 num_points, vec2f p0, vec2f p1, f32 radius) {
+    if (points == NULL || num_points < 2) {
+        return false;
+    }
+
+    f32 sqr_radius = radius * radius;
+
+    for (u32 i = 0; i + 1 < num_points; i++) {
+        if (_segment_collide_capsule_scalar(points[i], points[i + 1], p0, p1, sqr_radius)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void draw_segments_hit_capsule(const vec2f* points, u32 num_points, vec2f p0, vec2f p1, f32 radius, b8* hits) {
+    if (points == NULL || hits == NULL || num_points < 2) {
+        return;
+    }
+
+    f32 sqr_radius = radius * radius;
+
+    for (u32 i = 0; i + 1 < num_points; i++) {
+        hits[i] = _segment_collide_capsule_scalar(points[i], points[i + 1], p0, p1, sqr_radius);
+    }
+}
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef DRAW_COLLIDE_H
+#define DRAW_COLLIDE_H
+
+#include "base/base.h"
+
+// Returns true if any segment between consecutive points is closer than radius to pos.
+// Returns on the first hit. Uses AVX2 or SSE2 when the compiler targets them,
+// otherwise a scalar loop with the same math
+b32 draw_segments_collide_circle(const vec2f* points, u32 num_points, vec2f pos, f32 radius);
+// Same as above, but against every point closer than radius to the segment p0 -> p1
+b32 draw_segments_collide_capsule(const vec2f* points, u32 num_points, vec2f p0, vec2f p1, f32 radius);
+// Sets hits[i] for every segment i from points[i] to points[i + 1] that collides.
+// hits needs room for num_points - 1 flags
+void draw_segments_hit_capsule(const vec2f* points, u32 num_points, vec2f p0, vec2f p1, f32 radius, b8* hits);
+
+#endif // DRAW_COLLIDE_H
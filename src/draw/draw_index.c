@@ -0,0 +1,238 @@
+#include "draw_index.h"
+
+#include <stdio.h>
+#include <math.h>
+
+typedef struct {
+    // Inclusive cell coordinates
+    i32 min_x, min_y;
+    i32 max_x, max_y;
+} _index_range;
+
+static _index_range _index_range_from_rect(f32 cell_size, rectf rect) {
+    return (_index_range){
+        (i32)floorf(rect.x / cell_size),
+        (i32)floorf(rect.y / cell_size),
+        (i32)floorf((rect.x + rect.w) / cell_size),
+        (i32)floorf((rect.y + rect.h) / cell_size),
+    };
+}
+static u64 _index_range_cells(_index_range range) {
+    return (u64)(range.max_x - range.min_x + 1) * (u64)(range.max_y - range.min_y + 1);
+}
+static b32 _index_range_contains(_index_range range, i32 x, i32 y) {
+    return x >= range.min_x && x <= range.max_x && y >= range.min_y && y <= range.max_y;
+}
+
+static u32 _index_hash(i32 x, i32 y) {
+    return (((u32)x * 73856093u) ^ ((u32)y * 19349663u)) & (DRAW_INDEX_NUM_SLOTS - 1);
+}
+
+static draw_index_cell* _index_get_cell(draw_index* index, i32 x, i32 y, b32 create) {
+    draw_index_cell** slot = &index->slots[_index_hash(x, y)];
+
+    for (draw_index_cell* cell = *slot; cell != NULL; cell = cell->next) {
+        if (cell->x == x && cell->y == y) {
+            return cell;
+        }
+    }
+
+    if (!create) {
+        return NULL;
+    }
+
+    draw_index_cell* cell = MGA_PUSH_ZERO_STRUCT(index->arena, draw_index_cell);
+    cell->x = x;
+    cell->y = y;
+    cell->next = *slot;
+    *slot = cell;
+
+    return cell;
+}
+
+static void _index_list_push(draw_index* index, draw_index_entry** first, draw_lines* lines) {
+    draw_index_entry* entry = index->free_first;
+
+    if (entry != NULL) {
+        index->free_first = entry->next;
+    } else {
+        entry = MGA_PUSH_STRUCT(index->arena, draw_index_entry);
+    }
+
+    entry->lines = lines;
+    entry->next = *first;
+    *first = entry;
+}
+static void _index_list_remove(draw_index* index, draw_index_entry** first, draw_lines* lines) {
+    for (draw_index_entry** entry = first; *entry != NULL; entry = &(*entry)->next) {
+        if ((*entry)->lines == lines) {
+            draw_index_entry* removed = *entry;
+            *entry = removed->next;
+
+            removed->next = index->free_first;
+            index->free_first = removed;
+
+            return;
+        }
+    }
+}
+
+draw_index* draw_index_create(mg_arena* arena) {
+    draw_index* index = MGA_PUSH_ZERO_STRUCT(arena, draw_index);
+
+    index->arena = arena;
+    index->cell_size = DRAW_INDEX_CELL_SIZE;
+    index->slots = MGA_PUSH_ZERO_ARRAY(arena, draw_index_cell*, DRAW_INDEX_NUM_SLOTS);
+
+    return index;
+}
+
+void draw_index_insert(draw_index* index, draw_lines* lines) {
+    if (index == NULL || lines == NULL) {
+        fprintf(stderr, "Cannot insert lines into index: index or lines is NULL\n");
+        return;
+    }
+
+    lines->index = index;
+
+    if (lines->points.size == 0) {
+        // Cells get added once the first point comes in
+        return;
+    }
+
+    draw_index_update(index, lines, (rectf){ 0 }, true);
+}
+void draw_index_remove(draw_index* index, draw_lines* lines) {
+    if (index == NULL || lines == NULL) {
+        fprintf(stderr, "Cannot remove lines from index: index or lines is NULL\n");
+        return;
+    }
+
+    lines->index = NULL;
+
+    if (lines->points.size == 0) {
+        return;
+    }
+
+    _index_range range = _index_range_from_rect(index->cell_size, lines->bounding_box);
+
+    if (_index_range_cells(range) > DRAW_INDEX_MAX_CELLS) {
+        _index_list_remove(index, &index->large_first, lines);
+        return;
+    }
+
+    for (i32 y = range.min_y; y <= range.max_y; y++) {
+        for (i32 x = range.min_x; x <= range.max_x; x++) {
+            draw_index_cell* cell = _index_get_cell(index, x, y, false);
+
+            if (cell != NULL) {
+                _index_list_remove(index, &cell->first, lines);
+            }
+        }
+    }
+}
+void draw_index_update(draw_index* index, draw_lines* lines, rectf old_box, b32 old_empty) {
+    if (index == NULL || lines == NULL) {
+        fprintf(stderr, "Cannot update index: index or lines is NULL\n");
+        return;
+    }
+
+    _index_range new_range = _index_range_from_rect(index->cell_size, lines->bounding_box);
+    b32 new_large = _index_range_cells(new_range) > DRAW_INDEX_MAX_CELLS;
+
+    // Empty range so that the contains check always fails
+    _index_range old_range = { 1, 1, 0, 0 };
+    b32 old_large = false;
+
+    if (!old_empty) {
+        old_range = _index_range_from_rect(index->cell_size, old_box);
+        old_large = _index_range_cells(old_range) > DRAW_INDEX_MAX_CELLS;
+    }
+
+    if (old_large) {
+        // Bounding boxes only grow, so the lines stay in the large list
+        return;
+    }
+
+    if (new_large) {
+        for (i32 y = old_range.min_y; y <= old_range.max_y; y++) {
+            for (i32 x = old_range.min_x; x <= old_range.max_x; x++) {
+                draw_index_cell* cell = _index_get_cell(index, x, y, false);
+
+                if (cell != NULL) {
+                    _index_list_remove(index, &cell->first, lines);
+                }
+            }
+        }
+
+        _index_list_push(index, &index->large_first, lines);
+
+        return;
+    }
+
+    for (i32 y = new_range.min_y; y <= new_range.max_y; y++) {
+        for (i32 x = new_range.min_x; x <= new_range.max_x; x++) {
+            if (_index_range_contains(old_range, x, y)) {
+                continue;
+            }
+
+            draw_index_cell* cell = _index_get_cell(index, x, y, true);
+            _index_list_push(index, &cell->first, lines);
+        }
+    }
+}
+
+u32 draw_index_query_rect(draw_index* index, rectf rect, draw_lines** out, u32 max_out) {
+    if (index == NULL || out == NULL) {
+        fprintf(stderr, "Cannot query index: index or output is NULL\n");
+        return 0;
+    }
+
+    u32 num_out = 0;
+    u32 stamp = ++index->query_stamp;
+
+    for (draw_index_entry* entry = index->large_first; entry != NULL && num_out < max_out; entry = entry->next) {
+        if (rectf_collide_rectf(entry->lines->bounding_box, rect)) {
+            entry->lines->index_stamp = stamp;
+            out[num_out++] = entry->lines;
+        }
+    }
+
+    _index_range range = _index_range_from_rect(index->cell_size, rect);
+
+    for (i32 y = range.min_y; y <= range.max_y; y++) {
+        for (i32 x = range.min_x; x <= range.max_x; x++) {
+            draw_index_cell* cell = _index_get_cell(index, x, y, false);
+
+            if (cell == NULL) {
+                continue;
+            }
+
+            for (draw_index_entry* entry = cell->first; entry != NULL && num_out < max_out; entry = entry->next) {
+                draw_lines* lines = entry->lines;
+
+                if (lines->index_stamp == stamp || !rectf_collide_rectf(lines->bounding_box, rect)) {
+                    continue;
+                }
+
+                lines->index_stamp = stamp;
+                out[num_out++] = lines;
+            }
+        }
+    }
+
+    return num_out;
+}
+u32 draw_index_query_circle(draw_index* index, circlef circle, draw_lines** out, u32 max_out) {
+    rectf rect = {
+        circle.pos.x - circle.r,
+        circle.pos.y - circle.r,
+        circle.r * 2.0f,
+        circle.r * 2.0f
+    };
+
+    return draw_index_query_rect(index, rect, out, max_out);
+}
+u32 draw_index_query_capsule(draw_index* index, capsulef capsule, draw_lines** out, u32 max_out) {
+    return draw_index_query_rect(index, capsulef_bounds(capsule), out, max_out);
+}
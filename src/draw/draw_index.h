@@ -0,0 +1,60 @@
+#ifndef DRAW_INDEX_H
+#define DRAW_INDEX_H
+
+#include "base/base.h"
+#include "draw_lines.h"
+
+// World units per grid cell
+#define DRAW_INDEX_CELL_SIZE 128.0f
+// Number of hash slots, must be a power of two
+#define DRAW_INDEX_NUM_SLOTS 4096
+// Lines covering more cells than this are kept in a separate list
+// that every query checks, so giant strokes do not flood the grid
+#define DRAW_INDEX_MAX_CELLS 256
+
+typedef struct draw_index_entry {
+    struct draw_index_entry* next;
+    draw_lines* lines;
+} draw_index_entry;
+
+typedef struct draw_index_cell {
+    // Next cell in the same hash slot
+    struct draw_index_cell* next;
+
+    i32 x, y;
+
+    draw_index_entry* first;
+} draw_index_cell;
+
+typedef struct draw_index {
+    mg_arena* arena;
+
+    f32 cell_size;
+
+    draw_index_cell** slots;
+
+    // Lines that cover more than DRAW_INDEX_MAX_CELLS cells
+    draw_index_entry* large_first;
+
+    // Free list
+    draw_index_entry* free_first;
+
+    // Used to avoid returning the same lines twice in one query
+    u32 query_stamp;
+} draw_index;
+
+// Uniform grid over the bounding boxes of lines
+draw_index* draw_index_create(mg_arena* arena);
+
+// Starts tracking lines, the lines update the index as points get added or cleared
+void draw_index_insert(draw_index* index, draw_lines* lines);
+void draw_index_remove(draw_index* index, draw_lines* lines);
+// Called by the lines when the bounding box grows
+void draw_index_update(draw_index* index, draw_lines* lines, rectf old_box, b32 old_empty);
+
+// Fills out with every lines whose cells overlap rect, returns the number of lines written
+u32 draw_index_query_rect(draw_index* index, rectf rect, draw_lines** out, u32 max_out);
+u32 draw_index_query_circle(draw_index* index, circlef circle, draw_lines** out, u32 max_out);
+u32 draw_index_query_capsule(draw_index* index, capsulef capsule, draw_lines** out, u32 max_out);
+
+#endif // DRAW_INDEX_H
@@ -21,6 +21,17 @@ typedef struct {
     draw_point_allocator* allocator;
     draw_point_list points;
 
+    // Spatial index the lines are tracked in, can be NULL
+    struct draw_index* index;
+    u32 index_stamp;
+
+    // Batch the lines are drawn with, can be NULL
+    struct draw_batch* batch;
+    struct _draw_batch_entry* batch_entry;
+
+    // Stream that uploads new points, can be NULL
+    struct draw_stream* stream;
+
     struct _draw_lines_backend* backend;
 } draw_lines;
 
@@ -38,9 +49,22 @@ void draw_lines_draw(const draw_lines* lines, const draw_lines_shaders* shaders,
 // Updates the geometry of the lines with the new color and width
 void draw_lines_update(draw_lines* lines, vec4f col, f32 line_width);
 void draw_lines_add_point(draw_lines* lines, vec2f point);
+// Same as adding the points one by one, but the point buffer is resized and written only once
+void draw_lines_add_points(draw_lines* lines, const vec2f* points, u32 num_points);
 void draw_lines_change_last(draw_lines* lines, vec2f new_last);
 
+// Builds simplified geometry that gets drawn instead when zoomed out.
+// Meant for lines that are done changing, clearing the lines drops it
+void draw_lines_build_lods(draw_lines* lines);
+
 b32 draw_lines_collide_circle(draw_lines* lines, circlef circle);
+// Same test against everything closer than capsule.r to a segment, like the path of the eraser between two frames
+b32 draw_lines_collide_capsule(draw_lines* lines, capsulef capsule);
+// Cuts the segments that touch the capsule out of the lines and writes the pieces that are left
+// as new lines into pieces, which needs room for lines->points.size / 2 pieces.
+// The points of the pieces are copied on the GPU, their geometry is built by the shaders like for any other lines.
+// Returns false if nothing was hit. The lines themselves are not changed
+b32 draw_lines_split_capsule(mg_arena* arena, const draw_lines* lines, capsulef capsule, draw_lines** pieces, u32* num_pieces);
 
 #endif // DRAW_LINES_H
 
@@ -0,0 +1,30 @@
+#ifndef DRAW_OVERVIEW_H
+#define DRAW_OVERVIEW_H
+
+#include "base/base.h"
+#include "draw_lines.h"
+#include "draw_batch.h"
+#include "gfx/gfx.h"
+
+// Contents defined in draw backends
+typedef struct draw_overview draw_overview;
+
+// One mipmapped texture of every batched lines, for views zoomed out so far
+// that drawing the geometry would only fill a few pixels per lines
+draw_overview* draw_overview_create(mg_arena* arena);
+void draw_overview_destroy(draw_overview* overview);
+
+// Marks rect as changed, it gets rendered again the next time the overview is drawn.
+// Has to be called with the bounding box of lines when they join or leave the batch.
+// The area the texture covers doubles until it contains rect, which renders everything again
+void draw_overview_invalidate(draw_overview* overview, rectf rect);
+
+// Draws the batched lines from the texture if everything that was invalidated so far
+// covers less than max_screen_size pixels on the screen, and returns false without drawing anything otherwise.
+// Lines outside the batch are drawn on top with draw_lines_draw
+b32 draw_overview_draw(
+    draw_overview* overview, draw_batch* batch, draw_lines** lines, u32 num_lines,
+    const draw_lines_shaders* shaders, const gfx_window* win, viewf view, f32 max_screen_size
+);
+
+#endif // DRAW_OVERVIEW_H
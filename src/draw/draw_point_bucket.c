@@ -2,6 +2,7 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <math.h>
 
 draw_point_allocator* draw_point_alloc_create(mg_arena* backing_arena) {
     mg_arena* arena = backing_arena;
@@ -37,26 +38,45 @@ void draw_point_alloc_destroy(draw_point_allocator* point_alloc) {
     }
 }
 
-draw_point_bucket* draw_point_alloc_alloc(draw_point_allocator* point_alloc) {
+static u64 _bucket_bytes(u32 size_class) {
+    return sizeof(draw_point_bucket) + sizeof(vec2f) * DRAW_POINT_CLASS_SIZE(size_class);
+}
+
+draw_point_bucket* draw_point_alloc_alloc(draw_point_allocator* point_alloc, u32 size_class) {
     if (point_alloc == NULL) {
         fprintf(stderr, "Cannot alloc with NULL point allocator\n");
         return NULL;
     }
 
-    // Free node in list exists
-    if (point_alloc->free_first != NULL) {
-        draw_point_bucket* out = point_alloc->free_first;
+    if (size_class >= DRAW_POINT_NUM_CLASSES) {
+        fprintf(stderr, "Cannot alloc bucket of size class %u\n", size_class);
+        return NULL;
+    }
+
+    draw_point_bucket* out = NULL;
 
-        SLL_POP_FRONT(point_alloc->free_first, point_alloc->free_last);
+    // Free node in list exists
+    if (point_alloc->free_first[size_class] != NULL) {
+        out = point_alloc->free_first[size_class];
 
-        out->size = 0;
-        out->next = NULL;
-        memset(out->points, 0, sizeof(vec2f) * DRAW_POINT_BUCKET_SIZE);
+        SLL_POP_FRONT(point_alloc->free_first[size_class], point_alloc->free_last[size_class]);
 
-        return out;
+        point_alloc->stats.free_buckets--;
+    } else {
+        // Callers always write the points before reading them, so they are not zeroed
+        out = (draw_point_bucket*)mga_push(point_alloc->backing_arena, _bucket_bytes(size_class));
     }
 
-    draw_point_bucket* out = MGA_PUSH_ZERO_STRUCT(point_alloc->backing_arena, draw_point_bucket);
+    out->size = 0;
+    out->size_class = size_class;
+    out->bounds = (rectf){ 0 };
+    out->next = NULL;
+
+    draw_point_alloc_stats* stats = &point_alloc->stats;
+    stats->live_buckets++;
+    stats->live_bytes += _bucket_bytes(size_class);
+    stats->peak_live_buckets = MAX(stats->peak_live_buckets, stats->live_buckets);
+    stats->peak_live_bytes = MAX(stats->peak_live_bytes, stats->live_bytes);
 
     return out;
 }
@@ -66,7 +86,302 @@ void draw_point_alloc_free(draw_point_allocator* point_alloc, draw_point_bucket*
         return;
     }
 
-    SLL_PUSH_FRONT(point_alloc->free_first, point_alloc->free_last, bucket);
+    u32 size_class = bucket->size_class;
+    SLL_PUSH_FRONT(point_alloc->free_first[size_class], point_alloc->free_last[size_class], bucket);
+
+    point_alloc->stats.live_buckets--;
+    point_alloc->stats.live_bytes -= _bucket_bytes(size_class);
+    point_alloc->stats.free_buckets++;
+}
+void draw_point_alloc_free_chain(draw_point_allocator* point_alloc, draw_point_bucket* first, draw_point_bucket* last, u32 num_buckets) {
+    if (point_alloc == NULL) {
+        fprintf(stderr, "Cannot free with NULL point allocator\n");
+        return;
+    }
+
+    if (first == NULL || last == NULL) {
+        return;
+    }
+
+    u32 size_class = first->size_class;
+
+    last->next = point_alloc->free_first[size_class];
+    point_alloc->free_first[size_class] = first;
+
+    if (point_alloc->free_last[size_class] == NULL) {
+        point_alloc->free_last[size_class] = last;
+    }
+
+    point_alloc->stats.live_buckets -= num_buckets;
+    point_alloc->stats.live_bytes -= _bucket_bytes(size_class) * num_buckets;
+    point_alloc->stats.free_buckets += num_buckets;
+}
+draw_point_alloc_stats draw_point_alloc_get_stats(const draw_point_allocator* point_alloc) {
+    if (point_alloc == NULL) {
+        fprintf(stderr, "Cannot get stats of NULL point allocator\n");
+        return (draw_point_alloc_stats){ 0 };
+    }
+
+    return point_alloc->stats;
+}
+
+static u64 _sealed_bucket_bytes(u32 size_class) {
+    return sizeof(draw_point_sealed_bucket) + sizeof(i16) * 2 * DRAW_POINT_CLASS_SIZE(size_class);
+}
+
+static draw_point_sealed_bucket* _sealed_alloc(draw_point_allocator* point_alloc, u32 size_class) {
+    draw_point_sealed_bucket* out = NULL;
+
+    if (point_alloc->sealed_free_first[size_class] != NULL) {
+        out = point_alloc->sealed_free_first[size_class];
+
+        SLL_POP_FRONT(point_alloc->sealed_free_first[size_class], point_alloc->sealed_free_last[size_class]);
+
+        point_alloc->stats.free_buckets--;
+    } else {
+        out = (draw_point_sealed_bucket*)mga_push(point_alloc->backing_arena, _sealed_bucket_bytes(size_class));
+    }
+
+    out->size = 0;
+    out->size_class = size_class;
+    out->next = NULL;
+
+    draw_point_alloc_stats* stats = &point_alloc->stats;
+    stats->live_buckets++;
+    stats->live_bytes += _sealed_bucket_bytes(size_class);
+    stats->peak_live_buckets = MAX(stats->peak_live_buckets, stats->live_buckets);
+    stats->peak_live_bytes = MAX(stats->peak_live_bytes, stats->live_bytes);
+
+    return out;
+}
+static void _sealed_free(draw_point_allocator* point_alloc, draw_point_sealed_bucket* bucket) {
+    u32 size_class = bucket->size_class;
+    SLL_PUSH_FRONT(point_alloc->sealed_free_first[size_class], point_alloc->sealed_free_last[size_class], bucket);
+
+    point_alloc->stats.live_buckets--;
+    point_alloc->stats.live_bytes -= _sealed_bucket_bytes(size_class);
+    point_alloc->stats.free_buckets++;
+}
+static void _sealed_free_chain(draw_point_allocator* point_alloc, draw_point_sealed_bucket* first, draw_point_sealed_bucket* last, u32 num_buckets) {
+    if (first == NULL || last == NULL) {
+        return;
+    }
+
+    u32 size_class = first->size_class;
+
+    last->next = point_alloc->sealed_free_first[size_class];
+    point_alloc->sealed_free_first[size_class] = first;
+
+    if (point_alloc->sealed_free_last[size_class] == NULL) {
+        point_alloc->sealed_free_last[size_class] = last;
+    }
+
+    point_alloc->stats.live_buckets -= num_buckets;
+    point_alloc->stats.live_bytes -= _sealed_bucket_bytes(size_class) * num_buckets;
+    point_alloc->stats.free_buckets += num_buckets;
+}
+
+static rectf _bounds_add_point(rectf bounds, vec2f point) {
+    f32 min_x = MIN(bounds.x, point.x);
+    f32 min_y = MIN(bounds.y, point.y);
+    f32 max_x = MAX(bounds.x + bounds.w, point.x);
+    f32 max_y = MAX(bounds.y + bounds.h, point.y);
+
+    return (rectf){ min_x, min_y, max_x - min_x, max_y - min_y };
+}
+
+static u32 _dir_size_index(u32 capacity) {
+    u32 size_index = 0;
+
+    while ((DRAW_POINT_DIR_MIN_SIZE << size_index) < capacity) {
+        size_index++;
+    }
+
+    return size_index;
+}
+static void** _dir_alloc(draw_point_allocator* point_alloc, u32 capacity) {
+    u32 size_index = _dir_size_index(capacity);
+
+    if (size_index >= DRAW_POINT_DIR_NUM_SIZES) {
+        fprintf(stderr, "Cannot alloc bucket directory of capacity %u\n", capacity);
+        return NULL;
+    }
+
+    void** dir = point_alloc->free_dirs[size_index];
+
+    if (dir != NULL) {
+        point_alloc->free_dirs[size_index] = (void**)dir[0];
+        return dir;
+    }
+
+    return MGA_PUSH_ARRAY(point_alloc->backing_arena, void*, capacity);
+}
+static void _dir_free(draw_point_allocator* point_alloc, void** dir, u32 capacity) {
+    if (dir == NULL) {
+        return;
+    }
+
+    u32 size_index = _dir_size_index(capacity);
+
+    dir[0] = (void*)point_alloc->free_dirs[size_index];
+    point_alloc->free_dirs[size_index] = dir;
+}
+
+u32 draw_point_list_bucket_class(u32 bucket_index) {
+    return MIN(bucket_index, DRAW_POINT_NUM_CLASSES - 1);
+}
+u32 draw_point_list_bucket_start(u32 bucket_index) {
+    u32 start = 0;
+
+    for (u32 i = 0; i < DRAW_POINT_NUM_CLASSES - 1; i++) {
+        if (bucket_index == i) {
+            return start;
+        }
+
+        start += DRAW_POINT_CLASS_SIZE(i);
+    }
+
+    return start + (bucket_index - (DRAW_POINT_NUM_CLASSES - 1)) * DRAW_POINT_BUCKET_MAX_SIZE;
+}
+
+void draw_point_list_push_bucket(draw_point_list* list, draw_point_bucket* bucket) {
+    if (list == NULL || bucket == NULL) {
+        fprintf(stderr, "Cannot push bucket: list or bucket is NULL\n");
+        return;
+    }
+
+    if (list->sealed) {
+        fprintf(stderr, "Cannot push bucket to sealed list\n");
+        return;
+    }
+
+    if (list->num_buckets == list->dir_capacity) {
+        u32 new_capacity = list->dir_capacity == 0 ? DRAW_POINT_DIR_MIN_SIZE : list->dir_capacity * 2;
+        draw_point_bucket** new_dir = (draw_point_bucket**)_dir_alloc(list->allocator, new_capacity);
+
+        if (new_dir == NULL) {
+            return;
+        }
+
+        if (list->num_buckets > 0) {
+            memcpy(new_dir, list->buckets, sizeof(draw_point_bucket*) * list->num_buckets);
+        }
+
+        _dir_free(list->allocator, (void**)list->buckets, list->dir_capacity);
+
+        list->buckets = new_dir;
+        list->dir_capacity = new_capacity;
+    }
+
+    SLL_PUSH_BACK(list->first, list->last, bucket);
+    list->buckets[list->num_buckets++] = bucket;
+}
+u32 draw_point_list_locate(const draw_point_list* list, u32 index, u32* offset) {
+    if (list == NULL || index >= list->size) {
+        fprintf(stderr, "Cannot locate point %u: index out of bounds\n", index);
+        return 0;
+    }
+
+    u32 bucket_index = 0;
+    u32 start = 0;
+
+    // Walks the small classes, then jumps over the full size buckets
+    while (bucket_index < DRAW_POINT_NUM_CLASSES - 1 && index - start >= DRAW_POINT_CLASS_SIZE(bucket_index)) {
+        start += DRAW_POINT_CLASS_SIZE(bucket_index);
+        bucket_index++;
+    }
+
+    if (bucket_index == DRAW_POINT_NUM_CLASSES - 1) {
+        bucket_index += (index - start) / DRAW_POINT_BUCKET_MAX_SIZE;
+        start = draw_point_list_bucket_start(bucket_index);
+    }
+
+    if (offset != NULL) {
+        *offset = index - start;
+    }
+
+    return bucket_index;
+}
+
+static vec2f _sealed_origin(const draw_point_sealed_bucket* bucket) {
+    return (vec2f){
+        bucket->bounds.x + bucket->bounds.w * 0.5f,
+        bucket->bounds.y + bucket->bounds.h * 0.5f
+    };
+}
+static vec2f _sealed_decode(const draw_point_sealed_bucket* bucket, vec2f origin, u32 i) {
+    return (vec2f){
+        origin.x + (f32)bucket->offsets[i * 2 + 0] * bucket->step,
+        origin.y + (f32)bucket->offsets[i * 2 + 1] * bucket->step
+    };
+}
+
+vec2f draw_point_list_get(const draw_point_list* list, u32 index) {
+    if (list == NULL || index >= list->size) {
+        fprintf(stderr, "Cannot get point %u: index out of bounds\n", index);
+        return (vec2f){ 0 };
+    }
+
+    u32 offset = 0;
+    u32 bucket_index = draw_point_list_locate(list, index, &offset);
+
+    if (list->sealed) {
+        const draw_point_sealed_bucket* bucket = list->sealed_buckets[bucket_index];
+        return _sealed_decode(bucket, _sealed_origin(bucket), offset);
+    }
+
+    return list->buckets[bucket_index]->points[offset];
+}
+const vec2f* draw_point_list_bucket_points(const draw_point_list* list, u32 bucket_index, vec2f* scratch, u32* num_points) {
+    if (list == NULL || bucket_index >= list->num_buckets) {
+        fprintf(stderr, "Cannot get points of bucket %u: index out of bounds\n", bucket_index);
+        *num_points = 0;
+        return NULL;
+    }
+
+    if (!list->sealed) {
+        *num_points = list->buckets[bucket_index]->size;
+        return list->buckets[bucket_index]->points;
+    }
+
+    const draw_point_sealed_bucket* bucket = list->sealed_buckets[bucket_index];
+    vec2f origin = _sealed_origin(bucket);
+
+    for (u32 i = 0; i < bucket->size; i++) {
+        scratch[i] = _sealed_decode(bucket, origin, i);
+    }
+
+    *num_points = bucket->size;
+    return scratch;
+}
+rectf draw_point_list_bucket_bounds(const draw_point_list* list, u32 bucket_index) {
+    if (list == NULL || bucket_index >= list->num_buckets) {
+        fprintf(stderr, "Cannot get bounds of bucket %u: index out of bounds\n", bucket_index);
+        return (rectf){ 0 };
+    }
+
+    return list->sealed ? list->sealed_buckets[bucket_index]->bounds : list->buckets[bucket_index]->bounds;
+}
+
+void draw_point_list_copy(const draw_point_list* list, vec2f* out) {
+    if (list == NULL || out == NULL) {
+        fprintf(stderr, "Cannot copy points: list or output is NULL\n");
+        return;
+    }
+
+    u32 num_copied = 0;
+
+    for (u32 i = 0; i < list->num_buckets; i++) {
+        u32 num_points = 0;
+        // Sealed buckets decode straight into the output
+        const vec2f* points = draw_point_list_bucket_points(list, i, out + num_copied, &num_points);
+
+        if (points != out + num_copied) {
+            memcpy(out + num_copied, points, sizeof(vec2f) * num_points);
+        }
+
+        num_copied += num_points;
+    }
 }
 
 void draw_point_list_add(draw_point_list* list, vec2f point) {
@@ -75,19 +390,133 @@ void draw_point_list_add(draw_point_list* list, vec2f point) {
         return;
     }
 
+    if (list->sealed) {
+        fprintf(stderr, "Cannot add point to sealed list\n");
+        return;
+    }
+
     list->size++;
 
-    if (list->last == NULL || list->last->size == DRAW_POINT_BUCKET_SIZE) {
-        draw_point_bucket* bucket = draw_point_alloc_alloc(list->allocator);
+    if (list->last == NULL || list->last->size == DRAW_POINT_CLASS_SIZE(list->last->size_class)) {
+        u32 size_class = draw_point_list_bucket_class(list->num_buckets);
+        draw_point_bucket* bucket = draw_point_alloc_alloc(list->allocator, size_class);
         bucket->size = 1;
         bucket->points[0] = point;
+        bucket->bounds = (rectf){ point.x, point.y, 0.0f, 0.0f };
+
+        if (list->last != NULL) {
+            bucket->bounds = _bounds_add_point(bucket->bounds, list->last->points[list->last->size - 1]);
+        }
 
-        SLL_PUSH_BACK(list->first, list->last, bucket);
+        draw_point_list_push_bucket(list, bucket);
 
         return;
     }
 
     list->last->points[list->last->size++] = point;
+    list->last->bounds = _bounds_add_point(list->last->bounds, point);
+}
+
+// Largest offset written, leaves some room for the origin moving when the bounds get grown
+#define SEALED_MAX_OFFSET 32000.0f
+
+void draw_point_list_seal(draw_point_list* list, f32 step) {
+    if (list == NULL || step <= 0.0f) {
+        fprintf(stderr, "Cannot seal list: list is NULL or step is not positive\n");
+        return;
+    }
+
+    if (list->sealed || list->num_buckets == 0) {
+        return;
+    }
+
+    draw_point_sealed_bucket** sealed_dir = (draw_point_sealed_bucket**)_dir_alloc(list->allocator, list->dir_capacity);
+
+    if (sealed_dir == NULL) {
+        return;
+    }
+
+    f32 prev_step = 0.0f;
+
+    for (u32 b = 0; b < list->num_buckets; b++) {
+        const draw_point_bucket* bucket = list->buckets[b];
+        draw_point_sealed_bucket* sealed = _sealed_alloc(list->allocator, bucket->size_class);
+
+        f32 extent = MAX(bucket->bounds.w, bucket->bounds.h) * 0.5f;
+        sealed->step = MAX(step, extent / SEALED_MAX_OFFSET);
+        sealed->size = bucket->size;
+
+        // The first segment starts at the last point of the previous bucket,
+        // which can be off by that bucket's step
+        f32 pad = MAX(sealed->step, prev_step);
+        sealed->bounds = (rectf){
+            bucket->bounds.x - pad,
+            bucket->bounds.y - pad,
+            bucket->bounds.w + pad * 2.0f,
+            bucket->bounds.h + pad * 2.0f
+        };
+
+        vec2f origin = _sealed_origin(sealed);
+        f32 inv_step = 1.0f / sealed->step;
+
+        for (u32 i = 0; i < bucket->size; i++) {
+            f32 x = roundf((bucket->points[i].x - origin.x) * inv_step);
+            f32 y = roundf((bucket->points[i].y - origin.y) * inv_step);
+
+            sealed->offsets[i * 2 + 0] = (i16)CLAMP(x, -32767.0f, 32767.0f);
+            sealed->offsets[i * 2 + 1] = (i16)CLAMP(y, -32767.0f, 32767.0f);
+        }
+
+        SLL_PUSH_BACK(list->sealed_first, list->sealed_last, sealed);
+        sealed_dir[b] = sealed;
+
+        prev_step = sealed->step;
+    }
+
+    u32 size = list->size;
+    u32 num_buckets = list->num_buckets;
+    u32 dir_capacity = list->dir_capacity;
+    draw_point_sealed_bucket* sealed_first = list->sealed_first;
+    draw_point_sealed_bucket* sealed_last = list->sealed_last;
+
+    // Frees the raw buckets and their directory
+    list->sealed_first = NULL;
+    list->sealed_last = NULL;
+    draw_point_list_clear(list);
+
+    list->sealed = true;
+    list->size = size;
+    list->num_buckets = num_buckets;
+    list->dir_capacity = dir_capacity;
+    list->sealed_first = sealed_first;
+    list->sealed_last = sealed_last;
+    list->sealed_buckets = sealed_dir;
+}
+void draw_point_list_set_last(draw_point_list* list, vec2f point) {
+    if (list == NULL || list->last == NULL) {
+        fprintf(stderr, "Cannot set last point of empty or sealed list\n");
+        return;
+    }
+
+    // The bounds only grow, which keeps them conservative
+    list->last->points[list->last->size - 1] = point;
+    list->last->bounds = _bounds_add_point(list->last->bounds, point);
+}
+void draw_point_bucket_calc_bounds(draw_point_bucket* bucket, const draw_point_bucket* prev) {
+    if (bucket == NULL || bucket->size == 0) {
+        fprintf(stderr, "Cannot calculate bounds of empty bucket\n");
+        return;
+    }
+
+    bucket->bounds = (rectf){ bucket->points[0].x, bucket->points[0].y, 0.0f, 0.0f };
+
+    for (u32 i = 1; i < bucket->size; i++) {
+        bucket->bounds = _bounds_add_point(bucket->bounds, bucket->points[i]);
+    }
+
+    if (prev != NULL && prev->size > 0) {
+        bucket->bounds = _bounds_add_point(bucket->bounds, prev->points[prev->size - 1]);
+    }
 }
 void draw_point_list_clear(draw_point_list* list) {
     if (list == NULL) {
@@ -95,13 +524,40 @@ void draw_point_list_clear(draw_point_list* list) {
         return;
     }
 
-    while (list->first != NULL) {
-        draw_point_bucket* bucket = list->first;
-        SLL_POP_FRONT(list->first, list->last);
+    // Only the first few buckets are smaller than the largest class,
+    // everything after them goes back in one splice
+    if (list->sealed) {
+        while (list->sealed_first != NULL && list->sealed_first->size_class != DRAW_POINT_NUM_CLASSES - 1) {
+            draw_point_sealed_bucket* bucket = list->sealed_first;
+            SLL_POP_FRONT(list->sealed_first, list->sealed_last);
+            list->num_buckets--;
+
+            _sealed_free(list->allocator, bucket);
+        }
+
+        _sealed_free_chain(list->allocator, list->sealed_first, list->sealed_last, list->num_buckets);
+        _dir_free(list->allocator, (void**)list->sealed_buckets, list->dir_capacity);
+    } else {
+        while (list->first != NULL && list->first->size_class != DRAW_POINT_NUM_CLASSES - 1) {
+            draw_point_bucket* bucket = list->first;
+            SLL_POP_FRONT(list->first, list->last);
+            list->num_buckets--;
 
-        draw_point_alloc_free(list->allocator, bucket);
+            draw_point_alloc_free(list->allocator, bucket);
+        }
+
+        draw_point_alloc_free_chain(list->allocator, list->first, list->last, list->num_buckets);
+        _dir_free(list->allocator, (void**)list->buckets, list->dir_capacity);
     }
 
+    list->sealed = false;
+    list->first = NULL;
+    list->last = NULL;
+    list->sealed_first = NULL;
+    list->sealed_last = NULL;
+    list->buckets = NULL;
+    list->sealed_buckets = NULL;
+    list->dir_capacity = 0;
     list->size = 0;
+    list->num_buckets = 0;
 }
-
@@ -3,41 +3,128 @@
 
 #include "base/base.h"
 
-// Right now, this value is arbitrary
-#define DRAW_POINT_BUCKET_SIZE 64
+// Buckets come in size classes of 4, 16, 64 and 256 points.
+// Bucket n of a list uses class min(n, DRAW_POINT_NUM_CLASSES - 1),
+// so dots and short strokes only pay for a few points
+#define DRAW_POINT_NUM_CLASSES 4
+#define DRAW_POINT_CLASS_SIZE(size_class) (4u << (2u * (size_class)))
+#define DRAW_POINT_BUCKET_MAX_SIZE DRAW_POINT_CLASS_SIZE(DRAW_POINT_NUM_CLASSES - 1)
+
+// Bucket directories have power of two capacities starting at DRAW_POINT_DIR_MIN_SIZE
+#define DRAW_POINT_DIR_MIN_SIZE 4u
+#define DRAW_POINT_DIR_NUM_SIZES 28
 
 typedef struct draw_point_bucket {
-    u32 size;
-    vec2f points[DRAW_POINT_BUCKET_SIZE];
     struct draw_point_bucket* next;
+    // Contains the points of the bucket and the last point of the previous bucket,
+    // so every segment that ends in this bucket is inside of it
+    rectf bounds;
+    u32 size;
+    u32 size_class;
+    // DRAW_POINT_CLASS_SIZE(size_class) points
+    vec2f points[];
 } draw_point_bucket;
 
+// Bucket of a sealed list, same size classes as draw_point_bucket.
+// Points are stored as offsets from the center of bounds in multiples of step
+typedef struct draw_point_sealed_bucket {
+    struct draw_point_sealed_bucket* next;
+    // Same as draw_point_bucket, grown by step to cover the rounding
+    rectf bounds;
+    u32 size;
+    u32 size_class;
+    f32 step;
+    // x and y for DRAW_POINT_CLASS_SIZE(size_class) points
+    i16 offsets[];
+} draw_point_sealed_bucket;
+
+typedef struct {
+    u64 live_buckets;
+    u64 free_buckets;
+    // Highest number of live buckets at once
+    u64 peak_live_buckets;
+
+    // Bytes of bucket storage in use, including headers
+    u64 live_bytes;
+    u64 peak_live_bytes;
+} draw_point_alloc_stats;
+
 typedef struct {
     b32 owned_arena;
     mg_arena* backing_arena;
 
-    // Free list
-    draw_point_bucket* free_first;
-    draw_point_bucket* free_last;
+    // Free list per size class
+    draw_point_bucket* free_first[DRAW_POINT_NUM_CLASSES];
+    draw_point_bucket* free_last[DRAW_POINT_NUM_CLASSES];
+
+    draw_point_sealed_bucket* sealed_free_first[DRAW_POINT_NUM_CLASSES];
+    draw_point_sealed_bucket* sealed_free_last[DRAW_POINT_NUM_CLASSES];
+
+    // Free bucket directories per capacity,
+    // the first element of a free directory points to the next one
+    void** free_dirs[DRAW_POINT_DIR_NUM_SIZES];
+
+    draw_point_alloc_stats stats;
 } draw_point_allocator;
 
 typedef struct {
     u32 size;
+    u32 num_buckets;
 
     draw_point_allocator* allocator;
 
+    // Sealed lists only have sealed buckets and cannot be changed until cleared
+    b32 sealed;
+
     draw_point_bucket* first;
     draw_point_bucket* last;
+
+    draw_point_sealed_bucket* sealed_first;
+    draw_point_sealed_bucket* sealed_last;
+
+    // buckets[n] or sealed_buckets[n] is the nth bucket of the list
+    draw_point_bucket** buckets;
+    draw_point_sealed_bucket** sealed_buckets;
+    u32 dir_capacity;
 } draw_point_list;
 
 // backing_arena can be NULL
 draw_point_allocator* draw_point_alloc_create(mg_arena* backing_arena);
 void draw_point_alloc_destroy(draw_point_allocator* point_alloc);
-draw_point_bucket* draw_point_alloc_alloc(draw_point_allocator* point_alloc);
+// The points of the returned bucket are not cleared, size is zero
+draw_point_bucket* draw_point_alloc_alloc(draw_point_allocator* point_alloc, u32 size_class);
 void draw_point_alloc_free(draw_point_allocator* point_alloc, draw_point_bucket* bucket);
+// Moves a whole chain of buckets onto the free list in constant time,
+// every bucket in the chain needs to have the size class of first
+void draw_point_alloc_free_chain(draw_point_allocator* point_alloc, draw_point_bucket* first, draw_point_bucket* last, u32 num_buckets);
+draw_point_alloc_stats draw_point_alloc_get_stats(const draw_point_allocator* point_alloc);
+
+// Size class of the nth bucket in a list
+u32 draw_point_list_bucket_class(u32 bucket_index);
+// Index of the first point of the nth bucket in a list
+u32 draw_point_list_bucket_start(u32 bucket_index);
 
 // Create point lists on the stack
 void draw_point_list_add(draw_point_list* list, vec2f point);
+// Replaces every bucket with a sealed one, which takes about half the memory.
+// Points move by at most step / 2 in x and y, step grows for buckets too large for 16 bits
+void draw_point_list_seal(draw_point_list* list, f32 step);
+// Appends a bucket that was filled directly.
+// Every bucket before it has to be full for indexing to work
+void draw_point_list_push_bucket(draw_point_list* list, draw_point_bucket* bucket);
+// Returns the index of the bucket containing point index and its offset in that bucket in constant time
+u32 draw_point_list_locate(const draw_point_list* list, u32 index, u32* offset);
+vec2f draw_point_list_get(const draw_point_list* list, u32 index);
+// Returns the points of the nth bucket, decoding them into scratch if the list is sealed.
+// scratch needs room for DRAW_POINT_BUCKET_MAX_SIZE points
+const vec2f* draw_point_list_bucket_points(const draw_point_list* list, u32 bucket_index, vec2f* scratch, u32* num_points);
+rectf draw_point_list_bucket_bounds(const draw_point_list* list, u32 bucket_index);
+// Writes every point of the list to out, which needs room for list->size points
+void draw_point_list_copy(const draw_point_list* list, vec2f* out);
+// Replaces the most recent point
+void draw_point_list_set_last(draw_point_list* list, vec2f point);
+// Recomputes the bounds of a bucket after its points were written directly
+void draw_point_bucket_calc_bounds(draw_point_bucket* bucket, const draw_point_bucket* prev);
 void draw_point_list_clear(draw_point_list* list);
 
 #endif // DRAW_POINT_BUCKET_H
@@ -0,0 +1,35 @@
+#ifndef DRAW_REPROJECT_H
+#define DRAW_REPROJECT_H
+
+#include "base/base.h"
+#include "draw_lines.h"
+#include "draw_batch.h"
+#include "gfx/gfx.h"
+
+// Contents defined in draw backends
+typedef struct draw_reproject draw_reproject;
+
+typedef struct {
+    // Pixels of the last draw_reproject_draw that were drawn from the lines instead of the last frame
+    u32 num_rendered_pixels;
+} draw_reproject_stats;
+
+// Keeps the batched lines of the last frame in a texture the size of the window.
+// When the view only moved or zoomed, the texture gets moved along and only the newly exposed
+// parts of the screen are drawn from the lines. Pans move the texture by whole pixels, so they stay sharp.
+// Zooms resample it, so everything gets drawn again once the view stops changing
+draw_reproject* draw_reproject_create(mg_arena* arena);
+void draw_reproject_destroy(draw_reproject* reproject);
+
+// Has to be called with the bounding box of lines when they join or leave the batch.
+// Draws everything again in the next frame if rect is on the screen
+void draw_reproject_invalidate(draw_reproject* reproject, rectf rect);
+
+// Draws the batched lines, lines outside the batch are drawn on top with draw_lines_draw
+void draw_reproject_draw(
+    draw_reproject* reproject, draw_batch* batch, draw_lines** lines, u32 num_lines,
+    const draw_lines_shaders* shaders, const gfx_window* win, viewf view
+);
+draw_reproject_stats draw_reproject_get_stats(const draw_reproject* reproject);
+
+#endif // DRAW_REPROJECT_H
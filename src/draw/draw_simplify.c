@@ -0,0 +1,93 @@
+#include "draw_simplify.h"
+
+#include <stdio.h>
+
+typedef struct {
+    u32 start;
+    u32 end;
+} _simplify_range;
+
+// Squared distance from p to the segment a -> b
+static f32 _segment_sqr_dist(vec2f p, vec2f a, vec2f b) {
+    vec2f l = vec2f_sub(b, a);
+    vec2f d = vec2f_sub(p, a);
+
+    f32 sqr_len = vec2f_sqr_len(l);
+    f32 t = sqr_len > 0.0f ? vec2f_dot(d, l) / sqr_len : 0.0f;
+    t = CLAMP(t, 0.0f, 1.0f);
+
+    return vec2f_sqr_len(vec2f_sub(d, vec2f_scl(l, t)));
+}
+
+u32 draw_simplify_points(const vec2f* points, u32 num_points, f32 tolerance, vec2f* out) {
+    if (points == NULL || out == NULL) {
+        fprintf(stderr, "Cannot simplify points: points or output is NULL\n");
+        return 0;
+    }
+
+    if (num_points <= 2) {
+        for (u32 i = 0; i < num_points; i++) {
+            out[i] = points[i];
+        }
+
+        return num_points;
+    }
+
+    mga_temp scratch = mga_scratch_get(NULL, 0);
+
+    b8* keep = MGA_PUSH_ZERO_ARRAY(scratch.arena, b8, num_points);
+    // Each split pushes at most one more range than it pops
+    _simplify_range* stack = MGA_PUSH_ARRAY(scratch.arena, _simplify_range, num_points);
+    u32 stack_size = 0;
+
+    f32 sqr_tolerance = tolerance * tolerance;
+
+    keep[0] = true;
+    keep[num_points - 1] = true;
+    stack[stack_size++] = (_simplify_range){ 0, num_points - 1 };
+
+    // Explicit stack so long strokes cannot overflow the call stack
+    while (stack_size > 0) {
+        _simplify_range range = stack[--stack_size];
+
+        vec2f a = points[range.start];
+        vec2f b = points[range.end];
+
+        f32 max_sqr_dist = 0.0f;
+        u32 max_index = range.start;
+
+        for (u32 i = range.start + 1; i < range.end; i++) {
+            f32 sqr_dist = _segment_sqr_dist(points[i], a, b);
+
+            if (sqr_dist > max_sqr_dist) {
+                max_sqr_dist = sqr_dist;
+                max_index = i;
+            }
+        }
+
+        if (max_sqr_dist <= sqr_tolerance) {
+            continue;
+        }
+
+        keep[max_index] = true;
+
+        if (max_index - range.start > 1) {
+            stack[stack_size++] = (_simplify_range){ range.start, max_index };
+        }
+        if (range.end - max_index > 1) {
+            stack[stack_size++] = (_simplify_range){ max_index, range.end };
+        }
+    }
+
+    u32 num_out = 0;
+
+    for (u32 i = 0; i < num_points; i++) {
+        if (keep[i]) {
+            out[num_out++] = points[i];
+        }
+    }
+
+    mga_scratch_release(scratch);
+
+    return num_out;
+}
@@ -0,0 +1,12 @@
+#ifndef DRAW_SIMPLIFY_H
+#define DRAW_SIMPLIFY_H
+
+#include "base/base.h"
+
+// Ramer-Douglas-Peucker simplification of a polyline.
+// Every removed point is within tolerance of the simplified line,
+// the first and last point are always kept.
+// out needs room for num_points points, returns the number of points written
+u32 draw_simplify_points(const vec2f* points, u32 num_points, f32 tolerance, vec2f* out);
+
+#endif // DRAW_SIMPLIFY_H
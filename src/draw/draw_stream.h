@@ -0,0 +1,24 @@
+#ifndef DRAW_STREAM_H
+#define DRAW_STREAM_H
+
+#include "base/base.h"
+#include "draw_lines.h"
+
+// Contents defined in draw backends
+typedef struct draw_stream draw_stream;
+
+// Collects the GPU writes of lines that are still being drawn and uploads them together once per frame.
+// Uses a persistently mapped ring with fences where glBufferStorage is available, otherwise the
+// upload buffer gets orphaned on every flush
+draw_stream* draw_stream_create(mg_arena* arena);
+void draw_stream_destroy(draw_stream* stream);
+
+// New points of lines in the stream only reach the GPU with the next flush.
+// Lines leave the stream when they get cleared or destroyed, removing them writes what is left
+void draw_stream_add(draw_stream* stream, draw_lines* lines);
+void draw_stream_remove(draw_stream* stream, draw_lines* lines);
+
+// Writes everything added since the last flush, meant to be called once per frame before drawing
+void draw_stream_flush(draw_stream* stream);
+
+#endif // DRAW_STREAM_H
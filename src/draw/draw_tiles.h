@@ -0,0 +1,38 @@
+#ifndef DRAW_TILES_H
+#define DRAW_TILES_H
+
+#include "base/base.h"
+#include "draw_lines.h"
+#include "draw_batch.h"
+#include "gfx/gfx.h"
+
+// Contents defined in draw backends
+typedef struct draw_tiles draw_tiles;
+
+typedef struct {
+    // Tiles drawn and tiles that had to be rendered first, in the last draw_tiles_draw
+    u32 num_drawn;
+    u32 num_rendered;
+} draw_tiles_stats;
+
+// Caches the lines of a batch in textures. The world is split into square tiles for every zoom level,
+// where the texels of a level are a power of two in world units. Cached tiles stay until they get invalidated,
+// so frames that only move the view cost one textured quad per tile on the screen
+draw_tiles* draw_tiles_create(mg_arena* arena, u32 max_tiles);
+void draw_tiles_destroy(draw_tiles* tiles);
+
+// Marks the tiles of every zoom level that touch rect as out of date.
+// Has to be called with the bounding box of lines when they join or leave the batch
+void draw_tiles_invalidate(draw_tiles* tiles, rectf rect);
+void draw_tiles_invalidate_all(draw_tiles* tiles);
+
+// Draws the batched lines from the tiles, rendering the tiles that are missing or out of date with draw_batch_draw.
+// Lines outside the batch, like the stroke in progress, are drawn on top with draw_lines_draw.
+// Falls back to draw_batch_draw when the view needs more than max_tiles tiles
+void draw_tiles_draw(
+    draw_tiles* tiles, draw_batch* batch, draw_lines** lines, u32 num_lines,
+    const draw_lines_shaders* shaders, const gfx_window* win, viewf view
+);
+draw_tiles_stats draw_tiles_get_stats(const draw_tiles* tiles);
+
+#endif // DRAW_TILES_H
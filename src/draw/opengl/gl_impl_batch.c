@@ -0,0 +1,1242 @@
+#include "draw/draw.h"
+
+#ifdef DRAW_BACKEND_OPENGL
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "gfx/opengl/opengl.h"
+#include "gfx/opengl/opengl_helpers.h"
+
+// The full geometry plus one tier for each LOD level of gl_impl_lines.c
+#define BATCH_NUM_TIERS 4
+// Verts the buffer of a new batch has room for
+#define BATCH_INIT_VERT_CAPACITY 4096
+// Invocations per work group of the tessellation shader
+#define BATCH_TESS_GROUP_SIZE 64
+// Work groups per dispatch, the least every GL 4.3 implementation allows
+#define BATCH_TESS_MAX_GROUPS 65535
+// Invocations per work group of the culling shader
+#define BATCH_CULL_GROUP_SIZE 64
+
+// Defined in gl_impl_lines.c
+void _find_corners(const vec2f* points, u32 num_points, b8* corners);
+u32 _lod_level_points(const vec2f* points, u32 num_points, f32 width, u32 level, u32 prev_num_points, vec2f* out, f32* min_pixel_size);
+void _maybe_resize_buffer(u32 type, u32 elem_size, u32 size, u32* capacity, u32* buffer);
+
+typedef struct _draw_batch_entry {
+    struct _draw_batch_entry* prev;
+    struct _draw_batch_entry* next;
+
+    draw_lines* lines;
+
+    // Tier t is used once a screen pixel covers at least min_pixel_size[t] world units.
+    // Each tier is one triangle strip, tiers whose LOD level got skipped draw the strip of the tier before
+    f32 min_pixel_size[BATCH_NUM_TIERS];
+    u32 first_vert[BATCH_NUM_TIERS];
+    u32 num_tier_verts[BATCH_NUM_TIERS];
+
+    u32 num_verts;
+
+    // Compute path only. Points of each tier in the point buffer, skipped tiers have none
+    u32 first_point[BATCH_NUM_TIERS];
+    u32 num_level_points[BATCH_NUM_TIERS];
+
+    // Set until the geometry of the lines has been built by the next dispatch
+    b32 dirty;
+
+    // Used to find the lines that were not passed to draw_batch_maybe_compact
+    u32 stamp;
+} draw_batch_entry;
+
+typedef struct draw_batch {
+    mg_arena* arena;
+
+    u32 program;
+    u32 view_mat_loc;
+
+    u32 vertex_array;
+
+    // Every strip starts and ends with a repeated vert, so strips that are next to each other
+    // in the buffer draw as one with only empty triangles between them
+    u32 vert_buffer;
+    u32 vert_capacity;
+    u32 num_verts;
+
+    // Verts that belong to lines that left the batch
+    u32 wasted_verts;
+
+    draw_batch_entry* first;
+    u32 num_entries;
+
+    draw_batch_entry* free_first;
+
+    u32 stamp;
+
+    // Set when the context can run the tessellation shader, otherwise the geometry is built on the CPU.
+    // The shader writes the vertex buffer from the points, so changing the color
+    // or width of lines costs a dispatch instead of building and uploading the geometry again
+    b32 use_compute;
+
+    u32 tess_program;
+    u32 tess_num_jobs_loc;
+    u32 tess_num_threads_loc;
+    u32 tess_thread_offset_loc;
+
+    // Three words per point: x, y and the number of caps before the point times two,
+    // plus one if the point has a cap itself
+    u32 point_buffer;
+    u32 point_capacity;
+    u32 num_points;
+
+    // Filled from the dirty entries right before each dispatch
+    u32 job_buffer;
+
+    u32 num_dirty;
+
+    // Compute path only. The culling shader tests one record per batched lines against the view
+    // and writes the draw commands, so the CPU only looks for the lines outside the batch each frame.
+    // Records are in drawing order and get written again once the batch or the number of lines drawn changes
+    u32 cull_program;
+    u32 cull_num_records_loc;
+    u32 cull_view_rect_loc;
+    u32 cull_pixel_size_loc;
+
+    u32 record_buffer;
+    u32 command_buffer;
+    u32 command_capacity;
+    // Number of visible and culled records of the last draw
+    u32 stats_buffer;
+
+    u32 num_records;
+    b32 records_dirty;
+    draw_lines** records_lines;
+    u32 records_num_lines;
+
+    draw_batch_stats stats;
+} draw_batch;
+
+typedef struct {
+    vec2f pos;
+    u8 col[4];
+    // Position relative to the middle of the lines in half widths, normalized to [-1, 1].
+    // Segments only use x, caps use both
+    i8 local[2];
+    i8 pad[2];
+} batch_vert;
+
+// Everything the culling shader needs of one lines, laid out like its record struct
+typedef struct {
+    rectf box;
+    f32 min_pixel_size[BATCH_NUM_TIERS];
+    u32 first_vert[BATCH_NUM_TIERS];
+    u32 num_tier_verts[BATCH_NUM_TIERS];
+} _batch_record;
+
+// One tier of one lines for the tessellation shader, laid out like its job struct.
+// Every point of the tier gets an invocation
+typedef struct {
+    u32 first_thread;
+    u32 first_point;
+    u32 num_points;
+    u32 first_vert;
+    u32 col;
+    f32 half_w;
+} _batch_job;
+
+static const char* batch_vert_source;
+static const char* batch_frag_source;
+#ifndef PLATFORM_WASM
+static const char* batch_tess_source;
+static const char* batch_cull_source;
+#endif
+
+static void _batch_set_attribs(draw_batch* batch) {
+    glh_bind_vertex_array(batch->vertex_array);
+    glh_bind_buffer(GL_ARRAY_BUFFER, batch->vert_buffer);
+
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
+
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(batch_vert), (void*)offsetof(batch_vert, pos));
+    glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(batch_vert), (void*)offsetof(batch_vert, col));
+    glVertexAttribPointer(2, 2, GL_BYTE, GL_TRUE, sizeof(batch_vert), (void*)offsetof(batch_vert, local));
+}
+
+draw_batch* draw_batch_create(mg_arena* arena) {
+    draw_batch* batch = MGA_PUSH_ZERO_STRUCT(arena, draw_batch);
+
+    batch->arena = arena;
+
+    batch->program = glh_create_shader(batch_vert_source, batch_frag_source);
+    glh_use_program(batch->program);
+    batch->view_mat_loc = glGetUniformLocation(batch->program, "u_view_mat");
+    glh_use_program(0);
+
+    glGenVertexArrays(1, &batch->vertex_array);
+    glh_bind_vertex_array(batch->vertex_array);
+
+    batch->vert_capacity = BATCH_INIT_VERT_CAPACITY;
+    batch->vert_buffer = glh_create_buffer(
+        GL_ARRAY_BUFFER, sizeof(batch_vert) * batch->vert_capacity, NULL, GL_DYNAMIC_DRAW
+    );
+
+    _batch_set_attribs(batch);
+
+    glh_bind_vertex_array(0);
+    glh_bind_buffer(GL_ARRAY_BUFFER, 0);
+
+#ifndef PLATFORM_WASM
+    // WebGL 2 has no compute shaders
+    i32 major_version = 0;
+    i32 minor_version = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major_version);
+    glGetIntegerv(GL_MINOR_VERSION, &minor_version);
+
+    batch->use_compute = major_version > 4 || (major_version == 4 && minor_version >= 3);
+
+    if (batch->use_compute) {
+        batch->tess_program = glh_create_compute_shader(batch_tess_source);
+        glh_use_program(batch->tess_program);
+        batch->tess_num_jobs_loc = glGetUniformLocation(batch->tess_program, "u_num_jobs");
+        batch->tess_num_threads_loc = glGetUniformLocation(batch->tess_program, "u_num_threads");
+        batch->tess_thread_offset_loc = glGetUniformLocation(batch->tess_program, "u_thread_offset");
+        glh_use_program(0);
+
+        batch->point_capacity = BATCH_INIT_VERT_CAPACITY;
+        batch->point_buffer = glh_create_buffer(
+            GL_SHADER_STORAGE_BUFFER, sizeof(u32) * 3 * batch->point_capacity, NULL, GL_DYNAMIC_DRAW
+        );
+        batch->job_buffer = glh_create_buffer(GL_SHADER_STORAGE_BUFFER, 0, NULL, GL_STREAM_DRAW);
+
+        batch->cull_program = glh_create_compute_shader(batch_cull_source);
+        glh_use_program(batch->cull_program);
+        batch->cull_num_records_loc = glGetUniformLocation(batch->cull_program, "u_num_records");
+        batch->cull_view_rect_loc = glGetUniformLocation(batch->cull_program, "u_view_rect");
+        batch->cull_pixel_size_loc = glGetUniformLocation(batch->cull_program, "u_pixel_size");
+        glh_use_program(0);
+
+        batch->record_buffer = glh_create_buffer(GL_SHADER_STORAGE_BUFFER, 0, NULL, GL_DYNAMIC_DRAW);
+        batch->command_buffer = glh_create_buffer(GL_SHADER_STORAGE_BUFFER, 0, NULL, GL_DYNAMIC_COPY);
+        batch->stats_buffer = glh_create_buffer(GL_SHADER_STORAGE_BUFFER, sizeof(u32) * 2, NULL, GL_DYNAMIC_READ);
+
+        batch->records_dirty = true;
+
+        glh_bind_buffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+#endif
+
+    return batch;
+}
+void draw_batch_destroy(draw_batch* batch) {
+    if (batch == NULL) {
+        fprintf(stderr, "Cannot destroy batch: batch is NULL\n");
+        return;
+    }
+
+    glh_delete_program(batch->program);
+    glh_delete_vertex_arrays(1, &batch->vertex_array);
+    glh_delete_buffers(1, &batch->vert_buffer);
+
+    if (batch->use_compute) {
+        glh_delete_program(batch->tess_program);
+        glh_delete_buffers(1, &batch->point_buffer);
+        glh_delete_buffers(1, &batch->job_buffer);
+
+        glh_delete_program(batch->cull_program);
+        glh_delete_buffers(1, &batch->record_buffer);
+        glh_delete_buffers(1, &batch->command_buffer);
+        glh_delete_buffers(1, &batch->stats_buffer);
+    }
+}
+
+// Number of verts that _batch_build_level writes for the points
+static u32 _batch_count_level(const b8* corners, u32 num_points) {
+    if (num_points == 1) {
+        // Just the cap
+        return 6;
+    }
+
+    u32 num_corners = 0;
+    for (u32 i = 1; i + 1 < num_points; i++) {
+        num_corners += corners[i] ? 1 : 0;
+    }
+
+    // A pair per point, a second pair and two repeated verts per corner and both ends repeated.
+    // Then six verts for every cap
+    return 2 + 2 * num_points + 4 * num_corners + 6 * (num_corners + 2);
+}
+
+static void _batch_push_vert(batch_vert* verts, u32* num_verts, vec2f pos, const u8* col, i8 x, i8 y) {
+    verts[(*num_verts)++] = (batch_vert){ pos, { col[0], col[1], col[2], col[3] }, { x, y }, { 0 } };
+}
+// Two equal verts in a row only make empty triangles, which is how the strip jumps between parts
+static void _batch_repeat_vert(batch_vert* verts, u32* num_verts) {
+    verts[*num_verts] = verts[*num_verts - 1];
+    (*num_verts)++;
+}
+// Verts on both sides of p along the normal n
+static void _batch_push_pair(batch_vert* verts, u32* num_verts, vec2f p, vec2f n, const u8* col) {
+    _batch_push_vert(verts, num_verts, vec2f_sub(p, n), col, -127, 0);
+    _batch_push_vert(verts, num_verts, vec2f_add(p, n), col, 127, 0);
+}
+
+// Same segments as the segment shader of gl_impl_lines.c, except that segments run all the way into corners.
+// The corners and both ends get a square that the fragment shader cuts into a circle.
+// Everything is one triangle strip: the segments, then the squares, with repeated verts between the parts
+static void _batch_build_level(
+    const vec2f* points, u32 num_points, const b8* corners, f32 line_width, vec4f col, batch_vert* verts
+) {
+    u32 num_verts = 0;
+
+    f32 half_w = line_width * 0.5f;
+
+    u8 col_u8[4] = {
+        (u8)roundf(CLAMP(col.x, 0.0f, 1.0f) * 255.0f),
+        (u8)roundf(CLAMP(col.y, 0.0f, 1.0f) * 255.0f),
+        (u8)roundf(CLAMP(col.z, 0.0f, 1.0f) * 255.0f),
+        (u8)roundf(CLAMP(col.w, 0.0f, 1.0f) * 255.0f),
+    };
+
+    if (num_points > 1) {
+        vec2f n0 = vec2f_scl(vec2f_prp(vec2f_nrm(vec2f_sub(points[1], points[0]))), half_w);
+        _batch_push_vert(verts, &num_verts, vec2f_sub(points[0], n0), col_u8, -127, 0);
+        _batch_push_pair(verts, &num_verts, points[0], n0, col_u8);
+
+        for (u32 i = 1; i + 1 < num_points; i++) {
+            vec2f p0 = points[i - 1];
+            vec2f p1 = points[i];
+            vec2f p2 = points[i + 1];
+
+            vec2f l1 = vec2f_nrm(vec2f_sub(p1, p0));
+            vec2f n1 = vec2f_prp(l1);
+            vec2f l2 = vec2f_nrm(vec2f_sub(p2, p1));
+            vec2f n2 = vec2f_prp(l2);
+
+            if (corners[i]) {
+                // End of the first segment, then start of the second, the cap fills the gap
+                vec2f n2_w = vec2f_scl(n2, half_w);
+
+                _batch_push_pair(verts, &num_verts, p1, vec2f_scl(n1, half_w), col_u8);
+                _batch_repeat_vert(verts, &num_verts);
+                _batch_push_vert(verts, &num_verts, vec2f_sub(p1, n2_w), col_u8, -127, 0);
+                _batch_push_pair(verts, &num_verts, p1, n2_w, col_u8);
+            } else {
+                vec2f miter = vec2f_prp(vec2f_nrm(vec2f_add(l1, l2)));
+                f32 miter_scale = 1.0f / vec2f_dot(miter, n1);
+
+                _batch_push_pair(verts, &num_verts, p1, vec2f_scl(miter, half_w * miter_scale), col_u8);
+            }
+        }
+
+        vec2f pn = points[num_points - 1];
+        vec2f nn = vec2f_prp(vec2f_nrm(vec2f_sub(pn, points[num_points - 2])));
+        _batch_push_pair(verts, &num_verts, pn, vec2f_scl(nn, half_w), col_u8);
+        _batch_repeat_vert(verts, &num_verts);
+    }
+
+    // Round caps at both ends and at every corner
+    for (u32 i = 0; i < num_points; i++) {
+        if (i != 0 && i != num_points - 1 && !corners[i]) {
+            continue;
+        }
+
+        vec2f center = points[i];
+
+        for (u32 j = 0; j < 4; j++) {
+            i8 x = (j & 1) ? 127 : -127;
+            i8 y = (j & 2) ? 127 : -127;
+
+            vec2f pos = { center.x + (x > 0 ? half_w : -half_w), center.y + (y > 0 ? half_w : -half_w) };
+            _batch_push_vert(verts, &num_verts, pos, col_u8, x, y);
+
+            if (j == 0) {
+                _batch_repeat_vert(verts, &num_verts);
+            }
+        }
+
+        _batch_repeat_vert(verts, &num_verts);
+    }
+}
+
+// Appends the points of one tier to the point buffer, see draw_batch for the layout
+static void _batch_upload_points(draw_batch* batch, const vec2f* points, u32 num_points, const b8* corners, u32* words) {
+    u32 num_caps = 0;
+
+    for (u32 i = 0; i < num_points; i++) {
+        b32 cap = i == 0 || i == num_points - 1 || corners[i];
+
+        memcpy(&words[i * 3 + 0], &points[i].x, sizeof(u32));
+        memcpy(&words[i * 3 + 1], &points[i].y, sizeof(u32));
+        words[i * 3 + 2] = (num_caps << 1) | (cap ? 1 : 0);
+
+        num_caps += cap ? 1 : 0;
+    }
+
+    _maybe_resize_buffer(
+        GL_SHADER_STORAGE_BUFFER, sizeof(u32) * 3, batch->num_points + num_points,
+        &batch->point_capacity, &batch->point_buffer
+    );
+
+    glh_bind_buffer(GL_SHADER_STORAGE_BUFFER, batch->point_buffer);
+    glBufferSubData(
+        GL_SHADER_STORAGE_BUFFER, sizeof(u32) * 3 * batch->num_points,
+        sizeof(u32) * 3 * num_points, words
+    );
+    glh_bind_buffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    batch->num_points += num_points;
+}
+
+static void _batch_mark_dirty(draw_batch* batch, draw_batch_entry* entry) {
+    if (!entry->dirty) {
+        entry->dirty = true;
+        batch->num_dirty++;
+    }
+}
+
+void draw_batch_add(draw_batch* batch, draw_lines* lines) {
+    if (batch == NULL || lines == NULL) {
+        fprintf(stderr, "Cannot add lines to batch: batch or lines is NULL\n");
+        return;
+    }
+    if (lines->batch != NULL) {
+        fprintf(stderr, "Cannot add lines to batch: lines are already in a batch\n");
+        return;
+    }
+    if (lines->points.size == 0) {
+        fprintf(stderr, "Cannot add lines to batch: lines have zero points\n");
+        return;
+    }
+
+    draw_batch_entry* entry = batch->free_first;
+
+    if (entry != NULL) {
+        batch->free_first = entry->next;
+    } else {
+        entry = MGA_PUSH_STRUCT(batch->arena, draw_batch_entry);
+    }
+
+    memset(entry, 0, sizeof(draw_batch_entry));
+    entry->lines = lines;
+
+    entry->next = batch->first;
+    if (batch->first != NULL) {
+        batch->first->prev = entry;
+    }
+    batch->first = entry;
+    batch->num_entries++;
+
+    lines->batch = batch;
+    lines->batch_entry = entry;
+
+    batch->records_dirty = true;
+
+    mga_temp scratch = mga_scratch_get(NULL, 0);
+
+    u32 num_points = lines->points.size;
+    vec2f* points = MGA_PUSH_ARRAY(scratch.arena, vec2f, num_points);
+    vec2f* simplified = MGA_PUSH_ARRAY(scratch.arena, vec2f, num_points);
+    b8* corners = MGA_PUSH_ARRAY(scratch.arena, b8, num_points);
+
+    draw_point_list_copy(&lines->points, points);
+
+    u32 prev_size = num_points;
+
+    for (u32 t = 0; t < BATCH_NUM_TIERS; t++) {
+        const vec2f* level_points = points;
+        u32 level_size = num_points;
+
+        if (t > 0) {
+            level_size = _lod_level_points(
+                points, num_points, lines->width, t - 1, prev_size, simplified, &entry->min_pixel_size[t]
+            );
+            level_points = simplified;
+        }
+
+        // Skipped levels draw the same strip as the tier before
+        if (level_size == 0) {
+            entry->first_vert[t] = entry->first_vert[t - 1];
+            entry->num_tier_verts[t] = entry->num_tier_verts[t - 1];
+
+            continue;
+        }
+
+        prev_size = level_size;
+
+        _find_corners(level_points, level_size, corners);
+        u32 num_verts = _batch_count_level(corners, level_size);
+
+        u32 old_buffer = batch->vert_buffer;
+        _maybe_resize_buffer(
+            GL_ARRAY_BUFFER, sizeof(batch_vert), batch->num_verts + num_verts,
+            &batch->vert_capacity, &batch->vert_buffer
+        );
+        if (batch->vert_buffer != old_buffer) {
+            _batch_set_attribs(batch);
+        }
+
+        if (batch->use_compute) {
+            // The geometry gets written by the next dispatch
+            entry->first_point[t] = batch->num_points;
+            entry->num_level_points[t] = level_size;
+
+            u32* words = MGA_PUSH_ARRAY(scratch.arena, u32, level_size * 3);
+            _batch_upload_points(batch, level_points, level_size, corners, words);
+        } else {
+            batch_vert* verts = MGA_PUSH_ARRAY(scratch.arena, batch_vert, num_verts);
+
+            _batch_build_level(level_points, level_size, corners, lines->width, lines->color, verts);
+
+            glh_bind_buffer(GL_ARRAY_BUFFER, batch->vert_buffer);
+            glBufferSubData(GL_ARRAY_BUFFER, sizeof(batch_vert) * batch->num_verts, sizeof(batch_vert) * num_verts, verts);
+        }
+
+        entry->first_vert[t] = batch->num_verts;
+        entry->num_tier_verts[t] = num_verts;
+
+        batch->num_verts += num_verts;
+        entry->num_verts += num_verts;
+    }
+
+    glh_bind_vertex_array(0);
+    glh_bind_buffer(GL_ARRAY_BUFFER, 0);
+
+    if (batch->use_compute) {
+        _batch_mark_dirty(batch, entry);
+    }
+
+    mga_scratch_release(scratch);
+}
+void draw_batch_update(draw_batch* batch, draw_lines* lines) {
+    if (batch == NULL || lines == NULL) {
+        fprintf(stderr, "Cannot update lines in batch: batch or lines is NULL\n");
+        return;
+    }
+    if (lines->batch != batch) {
+        fprintf(stderr, "Cannot update lines in batch: lines are not in the batch\n");
+        return;
+    }
+
+    if (batch->use_compute) {
+        // The points stay, only the geometry and the record get written again
+        _batch_mark_dirty(batch, lines->batch_entry);
+        batch->records_dirty = true;
+    } else {
+        draw_batch_remove(batch, lines);
+        draw_batch_add(batch, lines);
+    }
+}
+void draw_batch_remove(draw_batch* batch, draw_lines* lines) {
+    if (batch == NULL || lines == NULL) {
+        fprintf(stderr, "Cannot remove lines from batch: batch or lines is NULL\n");
+        return;
+    }
+    if (lines->batch != batch) {
+        fprintf(stderr, "Cannot remove lines from batch: lines are not in the batch\n");
+        return;
+    }
+
+    draw_batch_entry* entry = lines->batch_entry;
+
+    // The space stays taken until the next compaction
+    batch->wasted_verts += entry->num_verts;
+
+    if (entry->dirty) {
+        batch->num_dirty--;
+    }
+
+    if (entry->prev != NULL) {
+        entry->prev->next = entry->next;
+    } else {
+        batch->first = entry->next;
+    }
+    if (entry->next != NULL) {
+        entry->next->prev = entry->prev;
+    }
+    batch->num_entries--;
+
+    entry->next = batch->free_first;
+    batch->free_first = entry;
+
+    lines->batch = NULL;
+    lines->batch_entry = NULL;
+
+    batch->records_dirty = true;
+}
+
+#ifndef PLATFORM_WASM
+
+// Builds the geometry of every dirty entry with the tessellation shader
+static void _batch_dispatch(draw_batch* batch) {
+    if (batch->num_dirty == 0) {
+        return;
+    }
+
+    mga_temp scratch = mga_scratch_get(NULL, 0);
+
+    _batch_job* jobs = MGA_PUSH_ARRAY(scratch.arena, _batch_job, batch->num_dirty * BATCH_NUM_TIERS);
+    u32 num_jobs = 0;
+    u32 num_threads = 0;
+
+    for (draw_batch_entry* entry = batch->first; entry != NULL; entry = entry->next) {
+        if (!entry->dirty) {
+            continue;
+        }
+
+        entry->dirty = false;
+
+        const draw_lines* lines = entry->lines;
+
+        u32 col = 0;
+        col |= (u32)roundf(CLAMP(lines->color.x, 0.0f, 1.0f) * 255.0f);
+        col |= (u32)roundf(CLAMP(lines->color.y, 0.0f, 1.0f) * 255.0f) << 8;
+        col |= (u32)roundf(CLAMP(lines->color.z, 0.0f, 1.0f) * 255.0f) << 16;
+        col |= (u32)roundf(CLAMP(lines->color.w, 0.0f, 1.0f) * 255.0f) << 24;
+
+        for (u32 t = 0; t < BATCH_NUM_TIERS; t++) {
+            u32 num_points = entry->num_level_points[t];
+
+            // Skipped tiers have no verts of their own
+            if (num_points == 0) {
+                continue;
+            }
+
+            jobs[num_jobs++] = (_batch_job){
+                .first_thread = num_threads,
+                .first_point = entry->first_point[t],
+                .num_points = num_points,
+                .first_vert = entry->first_vert[t],
+                .col = col,
+                .half_w = lines->width * 0.5f,
+            };
+
+            num_threads += num_points;
+        }
+    }
+
+    batch->num_dirty = 0;
+
+    glh_bind_buffer(GL_SHADER_STORAGE_BUFFER, batch->job_buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(_batch_job) * num_jobs, jobs, GL_STREAM_DRAW);
+    glh_bind_buffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, batch->point_buffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, batch->job_buffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, batch->vert_buffer);
+
+    glh_use_program(batch->tess_program);
+    glUniform1ui(batch->tess_num_jobs_loc, num_jobs);
+    glUniform1ui(batch->tess_num_threads_loc, num_threads);
+
+    u32 threads_per_dispatch = BATCH_TESS_GROUP_SIZE * BATCH_TESS_MAX_GROUPS;
+
+    for (u32 offset = 0; offset < num_threads; offset += threads_per_dispatch) {
+        u32 size = MIN(threads_per_dispatch, num_threads - offset);
+
+        glUniform1ui(batch->tess_thread_offset_loc, offset);
+        glDispatchCompute((size + BATCH_TESS_GROUP_SIZE - 1) / BATCH_TESS_GROUP_SIZE, 1, 1);
+    }
+
+    // Drawing reads the buffer as vertices, growing it copies it
+    glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    for (u32 i = 0; i < 3; i++) {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, i, 0);
+    }
+    glh_use_program(0);
+
+    mga_scratch_release(scratch);
+}
+
+// Writes a record for every batched lines in the order they are drawn in
+static void _batch_write_records(draw_batch* batch, draw_lines** lines, u32 num_lines) {
+    mga_temp scratch = mga_scratch_get(NULL, 0);
+
+    _batch_record* records = MGA_PUSH_ARRAY(scratch.arena, _batch_record, num_lines);
+
+    batch->num_records = 0;
+
+    for (u32 i = 0; i < num_lines; i++) {
+        draw_lines* cur = lines[i];
+
+        if (cur->batch != batch) {
+            continue;
+        }
+
+        const draw_batch_entry* entry = cur->batch_entry;
+        _batch_record* record = &records[batch->num_records++];
+
+        record->box = cur->bounding_box;
+        memcpy(record->min_pixel_size, entry->min_pixel_size, sizeof(record->min_pixel_size));
+        memcpy(record->first_vert, entry->first_vert, sizeof(record->first_vert));
+        memcpy(record->num_tier_verts, entry->num_tier_verts, sizeof(record->num_tier_verts));
+    }
+
+    glh_bind_buffer(GL_SHADER_STORAGE_BUFFER, batch->record_buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(_batch_record) * batch->num_records, records, GL_DYNAMIC_DRAW);
+
+    if (batch->num_records > batch->command_capacity) {
+        batch->command_capacity = MAX(batch->num_records, (u32)(batch->command_capacity * 1.5));
+
+        glh_bind_buffer(GL_SHADER_STORAGE_BUFFER, batch->command_buffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(u32) * 4 * batch->command_capacity, NULL, GL_DYNAMIC_COPY);
+    }
+
+    glh_bind_buffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    batch->records_dirty = false;
+    batch->records_lines = lines;
+    batch->records_num_lines = num_lines;
+
+    mga_scratch_release(scratch);
+}
+
+// Draws the commands of the records from first up to end with one call
+static void _batch_draw_commands(draw_batch* batch, const mat3f* view_mat, u32 first, u32 end) {
+    if (end <= first) {
+        return;
+    }
+
+    glh_use_program(batch->program);
+    glUniformMatrix3fv(batch->view_mat_loc, 1, GL_FALSE, view_mat->m);
+
+    glh_bind_vertex_array(batch->vertex_array);
+    glh_bind_buffer(GL_DRAW_INDIRECT_BUFFER, batch->command_buffer);
+
+    glMultiDrawArraysIndirect(GL_TRIANGLE_STRIP, (const void*)(sizeof(u32) * 4 * (u64)first), end - first, 0);
+
+    glh_bind_buffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    glh_use_program(0);
+    glh_bind_vertex_array(0);
+}
+
+// Culls and picks the tiers on the GPU. Only the lines outside the batch are looked at on the CPU
+static void _batch_draw_indirect(
+    draw_batch* batch, draw_lines** lines, u32 num_lines,
+    const draw_lines_shaders* shaders, const gfx_window* win, viewf view
+) {
+    if (batch->records_dirty || lines != batch->records_lines || num_lines != batch->records_num_lines) {
+        _batch_write_records(batch, lines, num_lines);
+    }
+
+    mat3f view_mat = { 0 };
+    mat3f_from_view(&view_mat, view);
+
+    rectf view_rect = viewf_bounds(view);
+
+    if (batch->num_records > 0) {
+        u32 zero_stats[2] = { 0, 0 };
+        glh_bind_buffer(GL_SHADER_STORAGE_BUFFER, batch->stats_buffer);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(zero_stats), zero_stats);
+        glh_bind_buffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, batch->record_buffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, batch->command_buffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, batch->stats_buffer);
+
+        glh_use_program(batch->cull_program);
+        glUniform1ui(batch->cull_num_records_loc, batch->num_records);
+        glUniform4f(batch->cull_view_rect_loc, view_rect.x, view_rect.y, view_rect.w, view_rect.h);
+        glUniform1f(batch->cull_pixel_size_loc, view.width / (f32)win->width);
+
+        // MAX_LINES in main.c stays far below the group limit
+        glDispatchCompute((batch->num_records + BATCH_CULL_GROUP_SIZE - 1) / BATCH_CULL_GROUP_SIZE, 1, 1);
+
+        glMemoryBarrier(GL_COMMAND_BARRIER_BIT);
+
+        for (u32 i = 0; i < 3; i++) {
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, i, 0);
+        }
+        glh_use_program(0);
+    }
+
+    // Lines outside the batch are found again every draw, they can be swapped in the array
+    // without the batch knowing, like the pieces while erasing. They only split the commands
+    // when they actually get drawn, before the record at the same position
+    u32 first = 0;
+    u32 num_batched = 0;
+
+    for (u32 i = 0; i < num_lines; i++) {
+        const draw_lines* cur = lines[i];
+
+        if (cur->batch == batch) {
+            num_batched++;
+            continue;
+        }
+
+        if (cur->points.size == 0) {
+            continue;
+        }
+
+        if (!rectf_collide_rectf(cur->bounding_box, view_rect)) {
+            batch->stats.num_culled++;
+            continue;
+        }
+
+        _batch_draw_commands(batch, &view_mat, first, num_batched);
+        first = num_batched;
+
+        batch->stats.num_visible++;
+        draw_lines_draw(cur, shaders, win, view);
+    }
+
+    _batch_draw_commands(batch, &view_mat, first, batch->num_records);
+}
+
+#endif
+
+// Draws the runs with one call, or one call per run where there is no multi draw
+static void _batch_flush(
+    draw_batch* batch, const mat3f* view_mat, const i32* counts, const i32* firsts, u32 num_runs
+) {
+    if (num_runs == 0) {
+        return;
+    }
+
+    glh_use_program(batch->program);
+    glUniformMatrix3fv(batch->view_mat_loc, 1, GL_FALSE, view_mat->m);
+
+    glh_bind_vertex_array(batch->vertex_array);
+
+#ifdef PLATFORM_WASM
+    // WebGL 2 has no multi draw
+    for (u32 i = 0; i < num_runs; i++) {
+        glDrawArrays(GL_TRIANGLE_STRIP, firsts[i], counts[i]);
+    }
+#else
+    glMultiDrawArrays(GL_TRIANGLE_STRIP, firsts, counts, num_runs);
+#endif
+
+    glh_use_program(0);
+    glh_bind_vertex_array(0);
+}
+
+void draw_batch_draw(
+    draw_batch* batch, draw_lines** lines, u32 num_lines,
+    const draw_lines_shaders* shaders, const gfx_window* win, viewf view
+) {
+    if (batch == NULL || lines == NULL) {
+        fprintf(stderr, "Cannot draw batch: batch or lines is NULL\n");
+        return;
+    }
+
+    mat3f view_mat = { 0 };
+    mat3f_from_view(&view_mat, view);
+
+    f32 pixel_size = view.width / (f32)win->width;
+    rectf view_rect = viewf_bounds(view);
+
+    batch->stats = (draw_batch_stats){ 0 };
+
+#ifndef PLATFORM_WASM
+    _batch_dispatch(batch);
+
+    if (batch->use_compute) {
+        _batch_draw_indirect(batch, lines, num_lines, shaders, win, view);
+        return;
+    }
+#endif
+
+    mga_temp scratch = mga_scratch_get(NULL, 0);
+
+    i32* counts = MGA_PUSH_ARRAY(scratch.arena, i32, num_lines);
+    i32* firsts = MGA_PUSH_ARRAY(scratch.arena, i32, num_lines);
+
+    u32 num_runs = 0;
+
+    for (u32 i = 0; i < num_lines; i++) {
+        draw_lines* cur = lines[i];
+
+        if (cur->points.size == 0) {
+            continue;
+        }
+
+        if (!rectf_collide_rectf(cur->bounding_box, view_rect)) {
+            batch->stats.num_culled++;
+            continue;
+        }
+
+        batch->stats.num_visible++;
+
+        if (cur->batch != batch) {
+            // Keeps the order, everything before gets drawn first
+            _batch_flush(batch, &view_mat, counts, firsts, num_runs);
+            num_runs = 0;
+
+            draw_lines_draw(cur, shaders, win, view);
+
+            continue;
+        }
+
+        const draw_batch_entry* entry = cur->batch_entry;
+
+        u32 tier = 0;
+        while (tier + 1 < BATCH_NUM_TIERS && pixel_size >= entry->min_pixel_size[tier + 1]) {
+            tier++;
+        }
+
+        i32 first = (i32)entry->first_vert[tier];
+        i32 count = (i32)entry->num_tier_verts[tier];
+
+        // Strips that follow each other in the buffer draw as one
+        if (num_runs > 0 && firsts[num_runs - 1] + counts[num_runs - 1] == first) {
+            counts[num_runs - 1] += count;
+        } else {
+            firsts[num_runs] = first;
+            counts[num_runs] = count;
+            num_runs++;
+        }
+    }
+
+    _batch_flush(batch, &view_mat, counts, firsts, num_runs);
+
+    mga_scratch_release(scratch);
+}
+
+u32 draw_batch_num_lines(const draw_batch* batch) {
+    return batch->num_entries;
+}
+
+// Splits lines into the ones in the batch and the others, both in the order given.
+// When every lines is in the batch, batched points at lines and nothing gets copied
+void _batch_split_lines(
+    const draw_batch* batch, draw_lines** lines, u32 num_lines, mg_arena* arena,
+    draw_lines*** batched, u32* num_batched, draw_lines*** others, u32* num_others
+) {
+    *batched = lines;
+    *num_batched = num_lines;
+    *others = NULL;
+    *num_others = 0;
+
+    if (batch->num_entries == num_lines) {
+        return;
+    }
+
+    *batched = MGA_PUSH_ARRAY(arena, draw_lines*, num_lines);
+    *others = MGA_PUSH_ARRAY(arena, draw_lines*, num_lines);
+    *num_batched = 0;
+
+    for (u32 i = 0; i < num_lines; i++) {
+        if (lines[i]->batch == batch) {
+            (*batched)[(*num_batched)++] = lines[i];
+        } else {
+            (*others)[(*num_others)++] = lines[i];
+        }
+    }
+}
+
+draw_batch_stats draw_batch_get_stats(const draw_batch* batch) {
+    if (batch == NULL) {
+        fprintf(stderr, "Cannot get batch stats: batch is NULL\n");
+        return (draw_batch_stats){ 0 };
+    }
+
+    draw_batch_stats stats = batch->stats;
+
+#ifndef PLATFORM_WASM
+    if (batch->use_compute && batch->num_records > 0) {
+        // Waits for the culling shader of the last draw
+        u32 gpu_stats[2] = { 0, 0 };
+
+        glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+        glh_bind_buffer(GL_SHADER_STORAGE_BUFFER, batch->stats_buffer);
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(gpu_stats), gpu_stats);
+        glh_bind_buffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        stats.num_visible += gpu_stats[0];
+        stats.num_culled += gpu_stats[1];
+    }
+#endif
+
+    return stats;
+}
+
+void draw_batch_maybe_compact(draw_batch* batch, draw_lines** lines, u32 num_lines) {
+    if (batch == NULL || lines == NULL) {
+        fprintf(stderr, "Cannot compact batch: batch or lines is NULL\n");
+        return;
+    }
+
+    if (batch->wasted_verts * 2 <= batch->num_verts) {
+        return;
+    }
+
+    mga_temp scratch = mga_scratch_get(NULL, 0);
+
+    u32 num_kept = 0;
+    draw_lines** kept = MGA_PUSH_ARRAY(scratch.arena, draw_lines*, batch->num_entries);
+
+    u32 stamp = ++batch->stamp;
+
+    for (u32 i = 0; i < num_lines; i++) {
+        if (lines[i] == NULL || lines[i]->batch != batch || lines[i]->batch_entry->stamp == stamp) {
+            continue;
+        }
+
+        lines[i]->batch_entry->stamp = stamp;
+        kept[num_kept++] = lines[i];
+    }
+
+    // Lines in the batch that were not passed go after
+    for (draw_batch_entry* entry = batch->first; entry != NULL; entry = entry->next) {
+        if (entry->stamp != stamp) {
+            kept[num_kept++] = entry->lines;
+        }
+    }
+
+    for (u32 i = 0; i < num_kept; i++) {
+        draw_batch_remove(batch, kept[i]);
+    }
+
+    batch->num_verts = 0;
+    batch->num_points = 0;
+    batch->wasted_verts = 0;
+
+    // The geometry is not kept on the CPU, so it gets built again from the points.
+    // On the compute path the points get uploaded again, now without the removed lines
+    for (u32 i = 0; i < num_kept; i++) {
+        draw_batch_add(batch, kept[i]);
+    }
+
+    mga_scratch_release(scratch);
+}
+
+static const char* batch_vert_source = GLSL_SOURCE(
+    330,
+
+    layout (location = 0) in vec2 a_pos;
+    layout (location = 1) in vec4 a_col;
+    layout (location = 2) in vec2 a_local;
+
+    out vec4 col;
+    out vec2 local;
+
+    uniform mat3 u_view_mat;
+
+    void main() {
+        col = a_col;
+        local = a_local;
+
+        vec2 pos = (u_view_mat * vec3(a_pos, 1.0)).xy;
+        gl_Position = vec4(pos, 0.0, 1.0);
+    }
+);
+
+static const char* batch_frag_source = GLSL_SOURCE(
+    330,
+    layout (location = 0) out vec4 out_col;
+
+    in vec4 col;
+    in vec2 local;
+
+    void main() {
+        // Same falloff as the segment shader, caps measure the distance to their center.
+        // Segments end at d = 0, the cap squares reach past it and get cut off there too
+        float d = 1.0 - length(local);
+        float blending = fwidth(d);
+        float alpha = smoothstep(-blending, blending, d) * step(0.0, d);
+
+        out_col = vec4(col.xyz, col.w * alpha);
+    }
+);
+
+#ifndef PLATFORM_WASM
+
+static const char* batch_tess_source = GLSL_SOURCE(
+    430,
+
+    layout (local_size_x = BATCH_TESS_GROUP_SIZE) in;
+
+    struct job {
+        uint first_thread;
+        uint first_point;
+        uint num_points;
+        uint first_vert;
+        uint col;
+        float half_w;
+    };
+
+    layout (std430, binding = 0) readonly buffer point_block { uint points[]; };
+    layout (std430, binding = 1) readonly buffer job_block { job jobs[]; };
+    layout (std430, binding = 2) writeonly buffer vert_block { uint verts[]; };
+
+    uniform uint u_num_jobs;
+    uniform uint u_num_threads;
+    uniform uint u_thread_offset;
+
+    job cur;
+
+    vec2 point_pos(uint i) {
+        return vec2(uintBitsToFloat(points[i * 3u]), uintBitsToFloat(points[i * 3u + 1u]));
+    }
+
+    // Same layout as batch_vert
+    void push_vert(inout uint v, vec2 pos, int local_x, int local_y) {
+        verts[v * 4u + 0u] = floatBitsToUint(pos.x);
+        verts[v * 4u + 1u] = floatBitsToUint(pos.y);
+        verts[v * 4u + 2u] = cur.col;
+        verts[v * 4u + 3u] = (uint(local_x) & 0xffu) | ((uint(local_y) & 0xffu) << 8u);
+
+        v++;
+    }
+    void push_pair(inout uint v, vec2 p, vec2 n) {
+        push_vert(v, p - n, -127, 0);
+        push_vert(v, p + n, 127, 0);
+    }
+    // The square gets its first and last vert twice, like in _batch_build_level
+    void push_cap(uint v, vec2 center) {
+        push_vert(v, center + vec2(-1.0, -1.0) * cur.half_w, -127, -127);
+        push_vert(v, center + vec2(-1.0, -1.0) * cur.half_w, -127, -127);
+        push_vert(v, center + vec2(1.0, -1.0) * cur.half_w, 127, -127);
+        push_vert(v, center + vec2(-1.0, 1.0) * cur.half_w, -127, 127);
+        push_vert(v, center + vec2(1.0, 1.0) * cur.half_w, 127, 127);
+        push_vert(v, center + vec2(1.0, 1.0) * cur.half_w, 127, 127);
+    }
+
+    // Each point writes its part of the segment strip and its cap. The offsets come from
+    // the cap counts, so the points do not depend on each other
+    void main() {
+        uint thread = gl_GlobalInvocationID.x + u_thread_offset;
+        if (thread >= u_num_threads) {
+            return;
+        }
+
+        // Last job that starts at or before the thread
+        uint lo = 0u;
+        uint hi = u_num_jobs - 1u;
+        while (lo < hi) {
+            uint mid = (lo + hi + 1u) / 2u;
+            if (jobs[mid].first_thread <= thread) {
+                lo = mid;
+            } else {
+                hi = mid - 1u;
+            }
+        }
+        cur = jobs[lo];
+
+        uint i = thread - cur.first_thread;
+        uint n = cur.num_points;
+        uint p = cur.first_point + i;
+
+        uint info = points[p * 3u + 2u];
+        uint caps = info >> 1u;
+        // Booleans would get renamed by stdbool.h
+        uint has_cap = info & 1u;
+
+        vec2 p1 = point_pos(p);
+
+        if (n == 1u) {
+            push_cap(cur.first_vert, p1);
+
+            return;
+        }
+
+        // Both ends have a cap, every other cap is a corner
+        uint num_corners = (points[(cur.first_point + n - 1u) * 3u + 2u] >> 1u) - 1u;
+        uint num_segment_verts = 2u + 2u * n + 4u * num_corners;
+
+        // After the repeated first vert, a pair per point and three more pairs per corner
+        uint v = cur.first_vert + 1u + 2u * i + (i > 0u ? 4u * (caps - 1u) : 0u);
+
+        if (i == 0u) {
+            vec2 l = normalize(point_pos(p + 1u) - p1);
+            vec2 nrm = vec2(-l.y, l.x) * cur.half_w;
+
+            v--;
+            push_vert(v, p1 - nrm, -127, 0);
+            push_pair(v, p1, nrm);
+        } else if (i == n - 1u) {
+            vec2 l = normalize(p1 - point_pos(p - 1u));
+            vec2 nrm = vec2(-l.y, l.x) * cur.half_w;
+
+            push_pair(v, p1, nrm);
+            push_vert(v, p1 + nrm, 127, 0);
+        } else {
+            vec2 l1 = normalize(p1 - point_pos(p - 1u));
+            vec2 n1 = vec2(-l1.y, l1.x);
+            vec2 l2 = normalize(point_pos(p + 1u) - p1);
+            vec2 n2 = vec2(-l2.y, l2.x);
+
+            if (has_cap == 1u) {
+                // End of the first segment, then start of the second, the cap fills the gap
+                push_pair(v, p1, n1 * cur.half_w);
+                push_vert(v, p1 + n1 * cur.half_w, 127, 0);
+                push_vert(v, p1 - n2 * cur.half_w, -127, 0);
+                push_pair(v, p1, n2 * cur.half_w);
+            } else {
+                vec2 tangent = normalize(l1 + l2);
+                vec2 miter = vec2(-tangent.y, tangent.x);
+                float miter_scale = 1.0 / dot(miter, n1);
+
+                push_pair(v, p1, miter * (cur.half_w * miter_scale));
+            }
+        }
+
+        if (has_cap == 1u) {
+            push_cap(cur.first_vert + num_segment_verts + 6u * caps, p1);
+        }
+    }
+);
+
+static const char* batch_cull_source = GLSL_SOURCE(
+    430,
+
+    layout (local_size_x = BATCH_CULL_GROUP_SIZE) in;
+
+    struct record {
+        vec4 box;
+        vec4 min_pixel_size;
+        uvec4 first_vert;
+        uvec4 num_tier_verts;
+    };
+
+    // Same layout as DrawArraysIndirectCommand
+    struct command {
+        uint count;
+        uint instance_count;
+        uint first;
+        uint base_instance;
+    };
+
+    layout (std430, binding = 0) readonly buffer record_block { record records[]; };
+    layout (std430, binding = 1) writeonly buffer command_block { command commands[]; };
+    layout (std430, binding = 2) buffer stats_block { uint num_visible; uint num_culled; };
+
+    uniform uint u_num_records;
+    uniform vec4 u_view_rect;
+    uniform float u_pixel_size;
+
+    void main() {
+        uint i = gl_GlobalInvocationID.x;
+        if (i >= u_num_records) {
+            return;
+        }
+
+        record r = records[i];
+
+        // Same test as rectf_collide_rectf
+        if (r.box.x + r.box.z < u_view_rect.x || r.box.x > u_view_rect.x + u_view_rect.z ||
+            r.box.y + r.box.w < u_view_rect.y || r.box.y > u_view_rect.y + u_view_rect.w) {
+            commands[i] = command(0u, 0u, 0u, 0u);
+            atomicAdd(num_culled, 1u);
+
+            return;
+        }
+
+        // Same choice as draw_batch_draw without compute shaders
+        int tier = 0;
+        while (tier + 1 < BATCH_NUM_TIERS && u_pixel_size >= r.min_pixel_size[tier + 1]) {
+            tier++;
+        }
+
+        commands[i] = command(r.num_tier_verts[tier], 1u, r.first_vert[tier], 0u);
+        atomicAdd(num_visible, 1u);
+    }
+);
+
+#endif
+
+#endif // DRAW_BACKEND_OPENGL
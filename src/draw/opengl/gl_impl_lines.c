@@ -13,50 +13,68 @@ typedef struct draw_lines_shaders {
     u32 line_program;
     u32 line_view_mat_loc;
     u32 line_col_loc;
+    u32 line_line_width_loc;
+    u32 line_num_points_loc;
 
     u32 corner_program;
     u32 corner_view_mat_loc;
     u32 corner_screen_loc;
     u32 corner_line_width_loc;
     u32 corner_col_loc;
+    u32 corner_num_points_loc;
 } draw_lines_shaders;
 
-typedef struct _draw_lines_backend {
-    // last_points[2] is the most recent point
-    vec2f last_points[3];
+// Simplified points that are drawn instead of the full points when zoomed out.
+// They use the vertex arrays of the lines, so only the buffer is separate
+typedef struct {
+    // Used once a screen pixel covers at least this many world units
+    f32 min_pixel_size;
+
+    u32 num_points;
+    u32 point_buffer;
+} _lines_lod;
 
-    u32 vert_capacity;
-    u32 index_capacity;
-    u32 corner_capacity;
+#define LOD_MAX_LEVELS 3
 
-    u32 num_verts;
-    u32 num_indices;
-    u32 num_corners;
+// The geometry is built in the vertex shaders. Segment i is an instance that reads the window of
+// points i - 1 to i + 2, corner i reads points i - 1 to i + 1. For the windows at the ends,
+// the point buffer repeats the first and the last point (see _pad_points)
+typedef struct _draw_lines_backend {
+    // Size of the point buffer in points, including the repeated ones
+    u32 point_capacity;
 
     // OpenGL objects
     u32 segment_array;
     u32 corner_array;
 
-    u32 vert_buffer;
-    u32 index_buffer;
-    u32 corner_buffer;
-} draw_lines_backend;
+    u32 point_buffer;
+    // Buffers the attributes of the vertex arrays read from, 0 until the first draw.
+    // Cleared when buffers get deleted, because their names can come back
+    u32 segment_attrib_buffer;
+    u32 corner_attrib_buffer;
 
-// Line vertex data
-typedef struct {
-    vec2f pos;
-} line_vert;
+    // Range of the point buffer that is waiting for the stream of the lines, empty if both are equal
+    u32 dirty_first;
+    u32 dirty_end;
 
-// Line corner instance data
-typedef struct {
-    vec2f p0;
-    vec2f p1;
-    vec2f p2;
-} line_corner;
+    // Sorted from finest to coarsest
+    _lines_lod lods[LOD_MAX_LEVELS];
+    u32 num_lods;
+} draw_lines_backend;
 
 #define AA_SMOOTHING 3
 #define TANGENT_EPSILON 1e-5
 #define MITER_LIMIT 1.2
+// Points the GPU buffers of new lines have room for
+#define INIT_POINT_CAPACITY 64
+
+// LOD level n is used once the lines are narrower than LOD_FIRST_WIDTH_PX / 4^n pixels,
+// its points are at most LOD_TOLERANCE_PX pixels off at that zoom
+#define LOD_FIRST_WIDTH_PX 4.0f
+#define LOD_TOLERANCE_PX 0.5f
+// Levels that keep more than this fraction of the points of the previous level are skipped
+#define LOD_MIN_REDUCTION 0.75f
+#define LOD_MIN_POINTS 16
 
 static const char* line_seg_vert;
 static const char* line_seg_frag;
@@ -69,17 +87,20 @@ draw_lines_shaders* draw_lines_shaders_create(mg_arena* arena) {
     shaders->line_program = glh_create_shader(line_seg_vert, line_seg_frag);
     shaders->corner_program = glh_create_shader(corner_vert, corner_frag);
 
-    glUseProgram(shaders->line_program);
+    glh_use_program(shaders->line_program);
     shaders->line_view_mat_loc = glGetUniformLocation(shaders->line_program, "u_view_mat");
     shaders->line_col_loc = glGetUniformLocation(shaders->line_program, "u_col");
+    shaders->line_line_width_loc = glGetUniformLocation(shaders->line_program, "u_line_width");
+    shaders->line_num_points_loc = glGetUniformLocation(shaders->line_program, "u_num_points");
 
-    glUseProgram(shaders->corner_program);
+    glh_use_program(shaders->corner_program);
     shaders->corner_view_mat_loc = glGetUniformLocation(shaders->corner_program, "u_view_mat");
     shaders->corner_screen_loc = glGetUniformLocation(shaders->corner_program, "u_screen");
     shaders->corner_line_width_loc = glGetUniformLocation(shaders->corner_program, "u_line_width");
     shaders->corner_col_loc = glGetUniformLocation(shaders->corner_program, "u_col");
+    shaders->corner_num_points_loc = glGetUniformLocation(shaders->corner_program, "u_num_points");
 
-    glUseProgram(0);
+    glh_use_program(0);
 
     return shaders;
 
@@ -90,8 +111,8 @@ void draw_lines_shaders_destroy(draw_lines_shaders* shaders) {
         return;
     }
 
-    glDeleteProgram(shaders->line_program);
-    glDeleteProgram(shaders->corner_program);
+    glh_delete_program(shaders->line_program);
+    glh_delete_program(shaders->corner_program);
 }
 
 b32 _is_corner(vec2f p0, vec2f p1, vec2f p2) {
@@ -115,16 +136,43 @@ b32 _is_corner(vec2f p0, vec2f p1, vec2f p2) {
     return miter_scale >= MITER_LIMIT || vec2f_sqr_len(vec2f_add(l1, l2)) <= TANGENT_EPSILON;
 }
 
-draw_lines* draw_lines_from_points(mg_arena* arena, draw_point_allocator* allocator, vec2f* points, u32 num_points, vec4f col, f32 line_width) {
-    if (num_points == 0) {
-        fprintf(stderr, "Cannot create lines with zero points\n");
-        return NULL;
+// Sets corners[i] for the points that get a corner instead of a mitered joint.
+// The first and last point never do
+void _find_corners(const vec2f* points, u32 num_points, b8* corners) {
+    corners[0] = false;
+    corners[num_points - 1] = false;
+
+    for (u32 i = 1; i + 1 < num_points; i++) {
+        corners[i] = _is_corner(points[i - 1], points[i], points[i + 1]);
     }
+}
+// Size of the point buffer for num_points points. A single point gets drawn as two caps,
+// the second of those reads one point past the repeated last point
+static u32 _padded_size(u32 num_points) {
+    return MAX(num_points + 2, 4);
+}
+// Copies the points with the first and the last point repeated, out needs room for _padded_size points
+static void _pad_points(const vec2f* points, u32 num_points, vec2f* out) {
+    out[0] = points[0];
+    memcpy(out + 1, points, sizeof(vec2f) * num_points);
 
-    draw_lines* lines = MGA_PUSH_ZERO_STRUCT(arena, draw_lines);
-    lines->points = (draw_point_list){ .allocator = allocator };
-    lines->backend = MGA_PUSH_ZERO_STRUCT(arena, draw_lines_backend);
+    for (u32 i = num_points + 1; i < _padded_size(num_points); i++) {
+        out[i] = points[num_points - 1];
+    }
+}
+
+static void _delete_lods(draw_lines_backend* backend) {
+    for (u32 i = 0; i < backend->num_lods; i++) {
+        glh_delete_buffers(1, &backend->lods[i].point_buffer);
+    }
+
+    backend->num_lods = 0;
+    backend->segment_attrib_buffer = 0;
+    backend->corner_attrib_buffer = 0;
+}
 
+// Fills the empty point list of the lines and sets the bounding box
+static void _lines_set_points(draw_lines* lines, const vec2f* points, u32 num_points) {
     vec2f min_pos = points[0];
     vec2f max_pos = points[0];
 
@@ -150,130 +198,56 @@ draw_lines* draw_lines_from_points(mg_arena* arena, draw_point_allocator* alloca
         (max_pos.y - min_pos.y) + lines->width * 2.0f
     };
 
-    lines->color = col;
-    lines->width = line_width;
-
-    lines->allocator = allocator;
-
     lines->points.size = num_points;
-    u32 num_buckets = (num_points + DRAW_POINT_BUCKET_SIZE - 1) / DRAW_POINT_BUCKET_SIZE;
-    for (u32 i = 0; i < num_buckets; i++) {
-        draw_point_bucket* bucket = draw_point_alloc_alloc(allocator);
+    for (u32 offset = 0; offset < num_points;) {
+        u32 size_class = draw_point_list_bucket_class(lines->points.num_buckets);
+        draw_point_bucket* bucket = draw_point_alloc_alloc(lines->allocator, size_class);
 
-        u32 size = i == num_buckets - 1 ? 
-            num_points - (DRAW_POINT_BUCKET_SIZE * (num_buckets - 1)) : DRAW_POINT_BUCKET_SIZE;
+        u32 size = MIN(DRAW_POINT_CLASS_SIZE(size_class), num_points - offset);
 
         bucket->size = size;
-        memcpy(bucket->points, points + i * DRAW_POINT_BUCKET_SIZE, sizeof(vec2f) * size);
+        memcpy(bucket->points, points + offset, sizeof(vec2f) * size);
+        offset += size;
+        draw_point_bucket_calc_bounds(bucket, lines->points.last);
 
-        SLL_PUSH_BACK(lines->points.first, lines->points.last, bucket);
+        draw_point_list_push_bucket(&lines->points, bucket);
     }
+}
 
-    lines->backend->num_indices = (num_points - 1) * 6;
-    if (num_points == 1) {
-        // Two corners will make a circle
-        lines->backend->num_corners = 2;
-
-        lines->backend->last_points[2] = points[0];
-    } else {
-        // At least two for end caps
-        lines->backend->num_corners = 2;
-        // At least two for first segment
-        lines->backend->num_verts = 2;
-
-        for (u32 i = 1; i < num_points - 1; i++) {
-            vec2f p0 = points[i - 1];
-            vec2f p1 = points[i];
-            vec2f p2 = points[i + 1];
-
-            if (_is_corner(p0, p1, p2)) {
-                lines->backend->num_corners++;
-                lines->backend->num_verts += 4;
-            } else {
-                lines->backend->num_verts += 2;
-            }
-        }
-
-        // End of last line segment
-        lines->backend->num_verts += 2;
-
-        if (num_points == 2) {
-            lines->backend->last_points[2] = points[1];
-            lines->backend->last_points[1] = points[0];
-        } else {
-            lines->backend->last_points[2] = points[num_points - 1];
-            lines->backend->last_points[1] = points[num_points - 2];
-            lines->backend->last_points[0] = points[num_points - 3];
-        }
+draw_lines* draw_lines_from_points(mg_arena* arena, draw_point_allocator* allocator, vec2f* points, u32 num_points, vec4f col, f32 line_width) {
+    if (num_points == 0) {
+        fprintf(stderr, "Cannot create lines with zero points\n");
+        return NULL;
     }
 
-    // Indices do not change here, so they can be computed beforehand
-    mga_temp scratch = mga_scratch_get(NULL, 0);
-    u32* indices = MGA_PUSH_ZERO_ARRAY(scratch.arena, u32, lines->backend->num_indices);
-
-    if (num_points > 1) {
-        u32 num_indices = 0;
-        u32 num_verts = 2;
-
-        for (u32 i = 1; i < num_points - 1; i++) {
-            vec2f p0 = points[i - 1];
-            vec2f p1 = points[i];
-            vec2f p2 = points[i + 1];
-
-            if (_is_corner(p0, p1, p2)) {
-                num_verts += 4;
-
-                indices[num_indices++] = num_verts - 6;
-                indices[num_indices++] = num_verts - 5;
-                indices[num_indices++] = num_verts - 4;
-
-                indices[num_indices++] = num_verts - 5;
-                indices[num_indices++] = num_verts - 3;
-                indices[num_indices++] = num_verts - 4;
-            } else {
-                num_verts += 2;
-
-                indices[num_indices++] = num_verts - 4;
-                indices[num_indices++] = num_verts - 3;
-                indices[num_indices++] = num_verts - 2;
+    draw_lines* lines = MGA_PUSH_ZERO_STRUCT(arena, draw_lines);
+    lines->points = (draw_point_list){ .allocator = allocator };
+    lines->backend = MGA_PUSH_ZERO_STRUCT(arena, draw_lines_backend);
 
-                indices[num_indices++] = num_verts - 3;
-                indices[num_indices++] = num_verts - 1;
-                indices[num_indices++] = num_verts - 2;
-            }
-        }
+    lines->color = col;
+    lines->width = line_width;
+    lines->allocator = allocator;
 
-        num_verts += 2;
+    _lines_set_points(lines, points, num_points);
 
-        indices[num_indices++] = num_verts - 4;
-        indices[num_indices++] = num_verts - 3;
-        indices[num_indices++] = num_verts - 2;
+    lines->backend->point_capacity = _padded_size(num_points);
 
-        indices[num_indices++] = num_verts - 3;
-        indices[num_indices++] = num_verts - 1;
-        indices[num_indices++] = num_verts - 2;
-    }
+    mga_temp scratch = mga_scratch_get(NULL, 0);
+    vec2f* padded = MGA_PUSH_ARRAY(scratch.arena, vec2f, lines->backend->point_capacity);
 
-    lines->backend->vert_capacity = lines->backend->num_verts;
-    lines->backend->index_capacity = lines->backend->num_indices;
-    lines->backend->corner_capacity = lines->backend->num_corners;
+    _pad_points(points, num_points, padded);
 
     // OpenGL stuff
     glGenVertexArrays(1, &lines->backend->segment_array);
-    glBindVertexArray(lines->backend->segment_array);
-
-    lines->backend->vert_buffer = glh_create_buffer(GL_ARRAY_BUFFER, sizeof(line_vert) * lines->backend->num_verts, NULL, GL_DYNAMIC_DRAW);
-    lines->backend->index_buffer = glh_create_buffer(GL_ELEMENT_ARRAY_BUFFER, sizeof(u32) * lines->backend->num_indices, indices, GL_STATIC_DRAW);
-
-    mga_scratch_release(scratch);
-
     glGenVertexArrays(1, &lines->backend->corner_array);
-    glBindVertexArray(lines->backend->corner_array);
 
-    lines->backend->corner_buffer = glh_create_buffer(GL_ARRAY_BUFFER, sizeof(line_corner) * lines->backend->num_corners, NULL, GL_DYNAMIC_DRAW);
+    lines->backend->point_buffer = glh_create_buffer(
+        GL_ARRAY_BUFFER, sizeof(vec2f) * lines->backend->point_capacity, padded, GL_DYNAMIC_DRAW
+    );
+
+    glh_bind_buffer(GL_ARRAY_BUFFER, 0);
 
-    // Computing the initial geometry
-    draw_lines_update(lines, col, line_width);
+    mga_scratch_release(scratch);
 
     return lines;
 }
@@ -288,26 +262,13 @@ draw_lines* draw_lines_create(mg_arena* arena, draw_point_allocator* allocator,
 
     lines->backend = MGA_PUSH_ZERO_STRUCT(arena, draw_lines_backend);
 
-    lines->backend->vert_capacity = DRAW_POINT_BUCKET_SIZE * 2;
-    lines->backend->index_capacity = (DRAW_POINT_BUCKET_SIZE - 1) * 6;
-    // TODO: is there a better starting value?
-    // how often are corners?
-    lines->backend->corner_capacity = 8;
+    lines->backend->point_capacity = _padded_size(INIT_POINT_CAPACITY);
 
     glGenVertexArrays(1, &lines->backend->segment_array);
     glGenVertexArrays(1, &lines->backend->corner_array);
 
-    glBindVertexArray(lines->backend->segment_array);
-    lines->backend->vert_buffer = glh_create_buffer(
-        GL_ARRAY_BUFFER, sizeof(line_vert) * lines->backend->vert_capacity, NULL, GL_DYNAMIC_DRAW
-    );
-    lines->backend->index_buffer = glh_create_buffer(
-        GL_ELEMENT_ARRAY_BUFFER, sizeof(u32) * lines->backend->index_capacity, NULL, GL_DYNAMIC_DRAW
-    );
-
-    glBindVertexArray(lines->backend->corner_array);
-    lines->backend->corner_buffer = glh_create_buffer(
-        GL_ARRAY_BUFFER, sizeof(line_corner) * lines->backend->corner_capacity, NULL, GL_DYNAMIC_DRAW
+    lines->backend->point_buffer = glh_create_buffer(
+        GL_ARRAY_BUFFER, sizeof(vec2f) * lines->backend->point_capacity, NULL, GL_DYNAMIC_DRAW
     );
 
     return lines;
@@ -318,14 +279,24 @@ void draw_lines_destroy(draw_lines* lines) {
         return;
     }
 
+    if (lines->index != NULL) {
+        draw_index_remove(lines->index, lines);
+    }
+    if (lines->batch != NULL) {
+        draw_batch_remove(lines->batch, lines);
+    }
+    if (lines->stream != NULL) {
+        lines->backend->dirty_end = lines->backend->dirty_first;
+        draw_stream_remove(lines->stream, lines);
+    }
+
     draw_point_list_clear(&lines->points);
+    _delete_lods(lines->backend);
 
-    glDeleteVertexArrays(1, &lines->backend->segment_array);
-    glDeleteVertexArrays(1, &lines->backend->corner_array);
+    glh_delete_vertex_arrays(1, &lines->backend->segment_array);
+    glh_delete_vertex_arrays(1, &lines->backend->corner_array);
 
-    glDeleteBuffers(1, &lines->backend->vert_buffer);
-    glDeleteBuffers(1, &lines->backend->index_buffer);
-    glDeleteBuffers(1, &lines->backend->corner_buffer);
+    glh_delete_buffers(1, &lines->backend->point_buffer);
 }
 
 void draw_lines_clear(draw_lines* lines) {
@@ -334,17 +305,26 @@ void draw_lines_clear(draw_lines* lines) {
         return;
     }
 
+    if (lines->index != NULL) {
+        // The lines stay tracked, cells get added back with the next points
+        draw_index* index = lines->index;
+        draw_index_remove(index, lines);
+        lines->index = index;
+    }
+    if (lines->batch != NULL) {
+        // New points make unfinished lines, those are not batched
+        draw_batch_remove(lines->batch, lines);
+    }
+    if (lines->stream != NULL) {
+        // Nothing left to write
+        lines->backend->dirty_end = lines->backend->dirty_first;
+        draw_stream_remove(lines->stream, lines);
+    }
+
     draw_point_list_clear(&lines->points);
+    _delete_lods(lines->backend);
 
     lines->bounding_box = (rectf){ 0 };
-
-    lines->backend->num_verts = 0;
-    lines->backend->num_indices = 0;
-    lines->backend->num_corners = 0;
-
-    lines->backend->last_points[0] = (vec2f){ 0 };
-    lines->backend->last_points[1] = (vec2f){ 0 };
-    lines->backend->last_points[2] = (vec2f){ 0 };
 }
 void draw_lines_reinit(draw_lines* lines, vec4f col, f32 width) {
     if (lines == NULL) {
@@ -356,237 +336,208 @@ void draw_lines_reinit(draw_lines* lines, vec4f col, f32 width) {
     lines->width = width;
 }
 
-void draw_lines_draw(const draw_lines* lines, const draw_lines_shaders* shaders, const gfx_window* win, viewf view) {
-    if (lines == NULL) {
-        fprintf(stderr, "Cannot draw lines: lines is NULL\n");
-        return;
+// Simplified points of one LOD level, returns 0 if the level does not drop enough points
+// compared to the previous one. min_pixel_size is set either way
+u32 _lod_level_points(const vec2f* points, u32 num_points, f32 width, u32 level, u32 prev_num_points, vec2f* out, f32* min_pixel_size) {
+    // World units per pixel at which the lines are LOD_FIRST_WIDTH_PX / 4^level pixels wide
+    *min_pixel_size = width / (LOD_FIRST_WIDTH_PX / (f32)(1u << (2 * level)));
+
+    if (num_points < LOD_MIN_POINTS) {
+        return 0;
     }
-    if (lines->points.size == 0) {
-        return;
+
+    u32 num_simplified = draw_simplify_points(points, num_points, LOD_TOLERANCE_PX * *min_pixel_size, out);
+
+    if ((f32)num_simplified > (f32)prev_num_points * LOD_MIN_REDUCTION) {
+        return 0;
     }
 
-    mat3f view_mat = { 0 };
-    mat3f_from_view(&view_mat, view);
+    return num_simplified;
+}
 
-    // Drawing line segments
-    glUseProgram(shaders->line_program);
-    glUniformMatrix3fv(shaders->line_view_mat_loc, 1, GL_FALSE, view_mat.m);
-    glUniform4f(shaders->line_col_loc, lines->color.x, lines->color.y, lines->color.z, lines->color.w);
+void draw_lines_build_lods(draw_lines* lines) {
+    if (lines == NULL) {
+        fprintf(stderr, "Cannot build lods: lines is NULL\n");
+        return;
+    }
 
-    glBindVertexArray(lines->backend->segment_array);
-    glBindBuffer(GL_ARRAY_BUFFER, lines->backend->vert_buffer);
+    _delete_lods(lines->backend);
 
-    glEnableVertexAttribArray(0);
+    if (lines->points.size < LOD_MIN_POINTS) {
+        return;
+    }
 
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(line_vert), (void*)(offsetof(line_vert, pos)));
+    mga_temp scratch = mga_scratch_get(NULL, 0);
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, lines->backend->index_buffer);
-    glDrawElements(GL_TRIANGLES, lines->backend->num_indices, GL_UNSIGNED_INT, NULL);
+    u32 num_points = lines->points.size;
+    vec2f* points = MGA_PUSH_ARRAY(scratch.arena, vec2f, num_points);
+    vec2f* simplified = MGA_PUSH_ARRAY(scratch.arena, vec2f, num_points);
 
-    glDisableVertexAttribArray(0);
+    draw_point_list_copy(&lines->points, points);
 
-    // Drawing corners
-    glUseProgram(shaders->corner_program);
-    glUniformMatrix3fv(shaders->corner_view_mat_loc, 1, GL_FALSE, view_mat.m);
-    glUniform4f(shaders->corner_col_loc, lines->color.x, lines->color.y, lines->color.z, lines->color.w);
-    //glUniform4f(shaders->corner_col_loc, 1, 0, 0, 1);
-    glUniform2f(shaders->corner_screen_loc, win->width, win->height);
-    glUniform1f(shaders->corner_line_width_loc, lines->width);
+    u32 prev_num_points = num_points;
 
-    glBindVertexArray(lines->backend->corner_array);
-    glBindBuffer(GL_ARRAY_BUFFER, lines->backend->corner_buffer);
+    for (u32 level = 0; level < LOD_MAX_LEVELS; level++) {
+        f32 pixel_size = 0.0f;
+        u32 num_simplified = _lod_level_points(points, num_points, lines->width, level, prev_num_points, simplified, &pixel_size);
 
-    glEnableVertexAttribArray(0);
-    glEnableVertexAttribArray(1);
-    glEnableVertexAttribArray(2);
+        if (num_simplified == 0) {
+            continue;
+        }
 
-    glVertexAttribDivisor(0, 1);
-    glVertexAttribDivisor(1, 1);
-    glVertexAttribDivisor(2, 1);
+        prev_num_points = num_simplified;
 
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(line_corner), (void*)offsetof(line_corner, p0));
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(line_corner), (void*)offsetof(line_corner, p1));
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(line_corner), (void*)offsetof(line_corner, p2));
+        _lines_lod* lod = &lines->backend->lods[lines->backend->num_lods++];
+        lod->min_pixel_size = pixel_size;
+        lod->num_points = num_simplified;
 
-    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 5, lines->backend->num_corners);
+        vec2f* padded = MGA_PUSH_ARRAY(scratch.arena, vec2f, _padded_size(num_simplified));
+        _pad_points(simplified, num_simplified, padded);
 
-    glVertexAttribDivisor(0, 0);
-    glVertexAttribDivisor(1, 0);
-    glVertexAttribDivisor(2, 0);
+        lod->point_buffer = glh_create_buffer(
+            GL_ARRAY_BUFFER, sizeof(vec2f) * _padded_size(num_simplified), padded, GL_STATIC_DRAW
+        );
+    }
 
-    glDisableVertexAttribArray(0);
-    glDisableVertexAttribArray(1);
-    glDisableVertexAttribArray(2);
+    glh_bind_buffer(GL_ARRAY_BUFFER, 0);
 
-    glUseProgram(0);
-    glBindVertexArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    mga_scratch_release(scratch);
 }
-void draw_lines_update(draw_lines* lines, vec4f col, f32 line_width) {
-    if (lines == NULL || lines->points.size == 0) {
-        fprintf(stderr, "Cannot update lines: invalid lines object\n");
+
+// mat3f_from_view of the last view drawn with. Lines of a frame share the view,
+// so it only gets computed again when the view changes
+static struct {
+    b32 valid;
+    viewf view;
+    mat3f mat;
+} _last_view;
+
+// Points the count attributes of the bound vertex array at consecutive points of the buffer,
+// one point per instance. Attribute state lives in the vertex array, so this is only needed when buffer changes
+static void _lines_set_attribs(u32* attrib_buffer, u32 buffer, u32 count) {
+    if (*attrib_buffer == buffer) {
         return;
     }
 
-    lines->color = col;
-    lines->width = line_width;
-
-    mga_temp scratch = mga_scratch_get(NULL, 0);
+    glh_bind_buffer(GL_ARRAY_BUFFER, buffer);
 
-    line_vert* verts = MGA_PUSH_ZERO_ARRAY(scratch.arena, line_vert, lines->backend->num_verts);
-    line_corner* corners = MGA_PUSH_ZERO_ARRAY(scratch.arena, line_corner, lines->backend->num_corners);
-    
-    u32 num_verts = 0;
-    u32 num_corners = 0;
+    // Attribute i is point i of the window
+    for (u32 i = 0; i < count; i++) {
+        glEnableVertexAttribArray(i);
+        glVertexAttribDivisor(i, 1);
+        glVertexAttribPointer(i, 2, GL_FLOAT, GL_FALSE, sizeof(vec2f), (void*)(sizeof(vec2f) * i));
+    }
 
-    if (lines->points.size == 1) {
-        vec2f point = lines->points.first->points[0];
+    *attrib_buffer = buffer;
+}
 
-        // Two corners form a circle here
-        corners[num_corners++] = (line_corner){
-            vec2f_add(point, (vec2f){ line_width * 1.1f, 0.0f }),
-            point,
-            vec2f_add(point, (vec2f){ line_width * 1.1f, 0.0f }),
-        };
-        corners[num_corners++] = (line_corner){
-            vec2f_sub(point, (vec2f){ line_width * 1.1f, 0.0f }),
-            point,
-            vec2f_sub(point, (vec2f){ line_width * 1.1f, 0.0f }),
-        };
-    } else {
-        // Points
-        vec2f p0, p1, p2;
-        // Lines and normals
-        vec2f l1, n1, l2, n2;
+void draw_lines_draw(const draw_lines* lines, const draw_lines_shaders* shaders, const gfx_window* win, viewf view) {
+    if (lines == NULL) {
+        fprintf(stderr, "Cannot draw lines: lines is NULL\n");
+        return;
+    }
+    if (lines->points.size == 0) {
+        return;
+    }
 
-        f32 half_w = lines->width * 0.5f;
+    if (!_last_view.valid || memcmp(&_last_view.view, &view, sizeof(viewf)) != 0) {
+        mat3f_from_view(&_last_view.mat, view);
+        _last_view.view = view;
+        _last_view.valid = true;
+    }
+    const mat3f* view_mat = &_last_view.mat;
 
-        draw_point_bucket* cur_bucket = lines->points.first;
-        u32 cur_num_buckets = 0;
+    draw_lines_backend* backend = lines->backend;
 
-        p0 = cur_bucket->points[0];
-        p1 = cur_bucket->points[1];
+    u32 num_points = lines->points.size;
+    u32 point_buffer = backend->point_buffer;
 
-        l1 = vec2f_nrm(vec2f_sub(p1, p0));
-        n1 = vec2f_prp(l1);
+    // Picks the coarsest level that is still accurate at this zoom
+    f32 pixel_size = view.width / (f32)win->width;
 
-        // Corner for rounded line cap
-        corners[num_corners++] = (line_corner){ p1, p0, p1 };
+    for (u32 i = 0; i < backend->num_lods && pixel_size >= backend->lods[i].min_pixel_size; i++) {
+        num_points = backend->lods[i].num_points;
+        point_buffer = backend->lods[i].point_buffer;
+    }
 
-        verts[num_verts++] = (line_vert){ vec2f_sub(p0, vec2f_scl(n1, half_w)) };
-        verts[num_verts++] = (line_vert){ vec2f_add(p0, vec2f_scl(n1, half_w)) };
+    // Bindings and uniforms are left as they are, the next lines mostly need the same ones
 
-        // This is to get the correct p0 and p1 values in the first iteration of the for loop
-        p1 = cur_bucket->points[0];
-        p2 = cur_bucket->points[1];
-        for (u32 i = 1; i < lines->points.size - 1; i++) {
-            p0 = p1;
-            p1 = p2;
+    // Drawing line segments, one instance per pair of points
+    glh_use_program(shaders->line_program);
+    glh_uniform_mat3f(shaders->line_view_mat_loc, view_mat->m);
+    glh_uniform_4f(shaders->line_col_loc, lines->color.x, lines->color.y, lines->color.z, lines->color.w);
+    glh_uniform_1f(shaders->line_line_width_loc, lines->width);
+    glh_uniform_1i(shaders->line_num_points_loc, num_points);
 
-            if (i + 1 >= (cur_num_buckets + 1) * DRAW_POINT_BUCKET_SIZE) {
-                if (cur_bucket->next == NULL) {
-                    fprintf(stderr, "Cannot update lines, not enough point buckets\n");
+    glh_bind_vertex_array(backend->segment_array);
+    _lines_set_attribs(&backend->segment_attrib_buffer, point_buffer, 4);
 
-                    // So that scratch arena gets released
-                    goto end;
-                }
+    if (num_points > 1) {
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, num_points - 1);
+    }
 
-                cur_bucket = cur_bucket->next;
-                cur_num_buckets++;
-            }
-            p2 = cur_bucket->points[i + 1 - cur_num_buckets * DRAW_POINT_BUCKET_SIZE];
-
-            l1 = vec2f_nrm(vec2f_sub(p1, p0));
-            n1 = vec2f_prp(l1);
-            l2 = vec2f_nrm(vec2f_sub(p2, p1));
-            n2 = vec2f_prp(l2);
-
-            // Avoiding issues with infinite miter projection
-            vec2f line_sum = vec2f_add(l1, l2);
-            vec2f tangent, miter;
-            f32 miter_scale;
-            if (vec2f_sqr_len(line_sum) < TANGENT_EPSILON) {
-                tangent = l1;
-                miter = n1;
-                miter_scale = 1.0f;
-            } else {
-                tangent = vec2f_nrm(vec2f_add(l1, l2));
-                miter = vec2f_prp(tangent);
-                miter_scale = 1.0f / vec2f_dot(miter, n1);
-            }
+    // Drawing corners, one instance per point. Points that are not corners come out empty
+    glh_use_program(shaders->corner_program);
+    glh_uniform_mat3f(shaders->corner_view_mat_loc, view_mat->m);
+    glh_uniform_4f(shaders->corner_col_loc, lines->color.x, lines->color.y, lines->color.z, lines->color.w);
+    glh_uniform_2f(shaders->corner_screen_loc, win->width, win->height);
+    glh_uniform_1f(shaders->corner_line_width_loc, lines->width);
+    glh_uniform_1i(shaders->corner_num_points_loc, num_points);
 
-            f32 line_cross = vec2f_crs(vec2f_sub(p1, p0), vec2f_sub(p2, p1));
-            // Some corner operations depend on which side of the points p1 is on
-            f32 s = -SIGN(line_cross);
+    glh_bind_vertex_array(backend->corner_array);
+    _lines_set_attribs(&backend->corner_attrib_buffer, point_buffer, 3);
 
-            if (miter_scale < MITER_LIMIT && vec2f_sqr_len(line_sum) > TANGENT_EPSILON) {
-                verts[num_verts++] = (line_vert){ vec2f_sub(p1, vec2f_scl(miter, half_w * miter_scale)) };
-                verts[num_verts++] = (line_vert){ vec2f_add(p1, vec2f_scl(miter, half_w * miter_scale)) };
-            } else {
-                corners[num_corners++] = (line_corner){ p0, p1, p2 };
-
-                // Point in the middle of line 1
-                vec2f l1_p = vec2f_add(
-                    vec2f_sub(p1, vec2f_scl(miter, s * half_w * miter_scale)),
-                    vec2f_scl(n1, s * half_w)
-                );
-                // Point in the middle of line 2
-                vec2f l2_p = vec2f_add(
-                    vec2f_sub(p1, vec2f_scl(miter, s * half_w * miter_scale)),
-                    vec2f_scl(n2, s * half_w)
-                );
-
-                // Getting parametric values for the line points
-                vec2f l1_vec = vec2f_sub(p1, p0);
-                f32 t1_unclamped = vec2f_dot(vec2f_sub(l1_p, p0), l1_vec) / vec2f_dot(l1_vec, l1_vec);
-                f32 t1 = CLAMP(t1_unclamped, 0, 1);
-
-                vec2f l2_vec = vec2f_sub(p1, p2);
-                f32 t2_unclamped = vec2f_dot(vec2f_sub(l2_p, p2), l2_vec) / vec2f_dot(l2_vec, l2_vec);
-                f32 t2 = CLAMP(t2_unclamped, 0, 1);
-
-                l1_p = vec2f_add(vec2f_scl(l1_vec, t1), p0);
-                l2_p = vec2f_add(vec2f_scl(l2_vec, t2), p2);
-
-                if (s == 1.0f) {
-                    verts[num_verts++] = (line_vert){ vec2f_sub(l1_p, vec2f_scl(n1, s * half_w)) };
-                    verts[num_verts++] = (line_vert){ vec2f_add(l1_p, vec2f_scl(n1, s * half_w)) };
-                    verts[num_verts++] = (line_vert){ vec2f_sub(l2_p, vec2f_scl(n2, s * half_w)) };
-                    verts[num_verts++] = (line_vert){ vec2f_add(l2_p, vec2f_scl(n2, s * half_w)) };
-                } else {
-                    verts[num_verts++] = (line_vert){ vec2f_add(l1_p, vec2f_scl(n1, s * half_w)) };
-                    verts[num_verts++] = (line_vert){ vec2f_sub(l1_p, vec2f_scl(n1, s * half_w)) };
-                    verts[num_verts++] = (line_vert){ vec2f_add(l2_p, vec2f_scl(n2, s * half_w)) };
-                    verts[num_verts++] = (line_vert){ vec2f_sub(l2_p, vec2f_scl(n2, s * half_w)) };
-                }
-            }
-        }
-        l2 = vec2f_nrm(vec2f_sub(p2, p1));
-        n2 = vec2f_prp(l2);
+    // A single point is two caps
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 5, MAX(num_points, 2));
+}
+void draw_lines_update(draw_lines* lines, vec4f col, f32 line_width) {
+    if (lines == NULL || lines->points.size == 0) {
+        fprintf(stderr, "Cannot update lines: invalid lines object\n");
+        return;
+    }
 
-        corners[num_corners++] = (line_corner){ p1, p2, p1 };
+    // The shaders build the geometry with the new width
+    lines->color = col;
+    lines->width = line_width;
 
-        verts[num_verts++] = (line_vert){ vec2f_sub(p2, vec2f_scl(n2, half_w)) };
-        verts[num_verts++] = (line_vert){ vec2f_add(p2, vec2f_scl(n2, half_w)) };
+    // The simplified points depend on the width
+    if (lines->backend->num_lods > 0) {
+        draw_lines_build_lods(lines);
     }
+    if (lines->batch != NULL) {
+        draw_batch_update(lines->batch, lines);
+    }
+}
 
-    glBindBuffer(GL_ARRAY_BUFFER, lines->backend->vert_buffer);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(line_vert) * lines->backend->num_verts, verts);
-    glBindBuffer(GL_ARRAY_BUFFER, lines->backend->corner_buffer);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(line_corner) * lines->backend->num_corners, corners);
+void _maybe_resize_buffer(u32 type, u32 elem_size, u32 size, u32* capacity, u32* buffer);
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+// Grows the point buffer to fit num_points padded points. A new buffer needs the attributes set up again,
+// even if it got the name of one deleted before
+static void _lines_resize_point_buffer(draw_lines* lines, u32 num_points) {
+    draw_lines_backend* backend = lines->backend;
 
-end: 
+    u32 old_buffer = backend->point_buffer;
+    _maybe_resize_buffer(
+        GL_ARRAY_BUFFER, sizeof(vec2f), _padded_size(num_points),
+        &backend->point_capacity, &backend->point_buffer
+    );
 
-    mga_scratch_release(scratch);
+    if (backend->point_buffer != old_buffer) {
+        backend->segment_attrib_buffer = 0;
+        backend->corner_attrib_buffer = 0;
+    }
 }
 
-void _maybe_resize_buffer(u32 type, u32 elem_size, u32 size, u32* capacity, u32* buffer);
+// Grows the bounding box to contain the point, the first point of the lines replaces it
+static void _lines_box_add(draw_lines* lines, vec2f point) {
+    if (lines->points.size == 1) {
+        lines->bounding_box = (rectf) {
+            point.x - lines->width,
+            point.y - lines->width,
+            lines->width * 2.0f,
+            lines->width * 2.0f,
+        };
 
-void draw_lines_add_point_internal(draw_lines* lines, vec2f point, b32 new) {
-    if (lines == NULL) {
-        fprintf(stderr, "Cannot add point to NULL lines\n");
         return;
     }
 
@@ -604,256 +555,144 @@ void draw_lines_add_point_internal(draw_lines* lines, vec2f point, b32 new) {
     if (point.y + lines->width > lines->bounding_box.y + lines->bounding_box.h) {
         lines->bounding_box.h += (point.y + lines->width) - (lines->bounding_box.y + lines->bounding_box.h);
     }
+}
 
-    vec2f* last_points = lines->backend->last_points;
-
-    vec2f prev_point = last_points[2];
-
-    if (new && lines->points.size > 3) {
-        last_points[2] = point;
-        lines->points.last->points[lines->points.last->size -1] = point;
-    } else {
-        new = false;
+// Writes size padded points from start into the point buffer, which has to be big enough already
+static void _lines_write_points(draw_lines* lines, u32 start, u32 size, const vec2f* padded) {
+    if (lines->stream != NULL) {
+        // Written with everything else from this frame when the stream gets flushed
+        draw_lines_backend* backend = lines->backend;
 
-        draw_point_list_add(&lines->points, point);
+        if (backend->dirty_first == backend->dirty_end) {
+            backend->dirty_first = start;
+            backend->dirty_end = start + size;
+        } else {
+            backend->dirty_first = MIN(backend->dirty_first, start);
+            backend->dirty_end = MAX(backend->dirty_end, start + size);
+        }
 
-        last_points[0] = last_points[1];
-        last_points[1] = last_points[2];
-        last_points[2] = point;
+        return;
     }
 
-    if (lines->points.size == 1) {
-        lines->bounding_box = (rectf) {
-            point.x - lines->width,
-            point.y - lines->width,
-            lines->width * 2.0f,
-            lines->width * 2.0f,
-        };
-
-        vec2f point = lines->points.first->points[0];
-
-        lines->backend->num_corners = 2;
-        line_corner corners[2] = { 
-            {
-                vec2f_add(point, (vec2f){ lines->width * 1.1f, 0.0f }),
-                point,
-                vec2f_add(point, (vec2f){ lines->width * 1.1f, 0.0f }),
-            },
-            {
-                vec2f_sub(point, (vec2f){ lines->width * 1.1f, 0.0f }),
-                point,
-                vec2f_sub(point, (vec2f){ lines->width * 1.1f, 0.0f }),
-            }
-        };
+    glh_bind_buffer(GL_ARRAY_BUFFER, lines->backend->point_buffer);
+    glBufferSubData(GL_ARRAY_BUFFER, sizeof(vec2f) * start, sizeof(vec2f) * size, padded);
+    glh_bind_buffer(GL_ARRAY_BUFFER, 0);
+}
 
-        glBindBuffer(GL_ARRAY_BUFFER, lines->backend->corner_buffer);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(corners), corners);
-    } else if (lines->points.size == 2) {
-        vec2f p0 = lines->points.first->points[0];
-        vec2f p1 = lines->points.first->points[1];
+void draw_lines_add_point_internal(draw_lines* lines, vec2f point, b32 new) {
+    if (lines == NULL) {
+        fprintf(stderr, "Cannot add point to NULL lines\n");
+        return;
+    }
 
-        lines->backend->num_corners = 2;
-        lines->backend->num_verts = 4;
-        lines->backend->num_indices = 6;
+    if (lines->points.sealed) {
+        fprintf(stderr, "Cannot add point to sealed lines\n");
+        return;
+    }
 
-        line_corner corners[2] = {
-            { p1, p0, p1 },
-            { p0, p1, p0 }
-        };
+    rectf old_box = lines->bounding_box;
+    b32 old_empty = lines->points.size == 0;
 
-        f32 half_w = lines->width * 0.5f;
-        vec2f line = vec2f_nrm(vec2f_sub(p1, p0));
-        vec2f norm = vec2f_prp(line);
+    if (new && lines->points.size > 3) {
+        draw_point_list_set_last(&lines->points, point);
+    } else {
+        draw_point_list_add(&lines->points, point);
+    }
 
-        line_vert verts[4] = {
-            { vec2f_sub(p0, vec2f_scl(norm, half_w)) },
-            { vec2f_add(p0, vec2f_scl(norm, half_w)) },
-            { vec2f_sub(p1, vec2f_scl(norm, half_w)) },
-            { vec2f_add(p1, vec2f_scl(norm, half_w)) },
-        };
+    _lines_box_add(lines, point);
 
-        u32 indices[6] = {
-            0, 1, 2,
-            1, 3, 2
-        };
+    if (lines->index != NULL) {
+        draw_index_update(lines->index, lines, old_box, old_empty);
+    }
 
-        glBindBuffer(GL_ARRAY_BUFFER, lines->backend->vert_buffer);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(verts), verts);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, lines->backend->index_buffer);
-        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, sizeof(indices), indices);
-        glBindBuffer(GL_ARRAY_BUFFER, lines->backend->corner_buffer);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(corners), corners);
-    } else {
-        if (lines->backend->num_verts < 2 || lines->backend->num_corners < 1) {
-            fprintf(stderr, "Cannot add point to draw_lines, not enough geometry\n");
-            return;
-        }
+    u32 num_points = lines->points.size;
 
-        if (!new) {
-            // Replacing the two more recent verts
-            lines->backend->num_verts -= 2;
-            // Replacing end cap
-            lines->backend->num_corners -= 1;
-            // Always append the same number of indices
-            lines->backend->num_indices += 6;
-        } else {
-            if (_is_corner(last_points[0], last_points[1], prev_point)) {
-                lines->backend->num_verts -= 6;
-                lines->backend->num_corners -= 2;
-            } else {
-                lines->backend->num_verts -= 4;
-                lines->backend->num_corners -= 1;
-            }
-        }
+    _lines_resize_point_buffer(lines, num_points);
 
-        // Saving these values for the glBufferSubData calls later
-        u32 start_verts = lines->backend->num_verts;
-        u32 start_indices = lines->backend->num_indices - 6;
-        u32 start_corners = lines->backend->num_corners;
+    // The point goes after the repeated first point, and gets repeated itself.
+    // The geometry of the points before it follows in the shaders
+    vec2f padded[4] = { point, point, point, point };
+    u32 start = num_points == 1 ? 0 : num_points;
+    u32 size = num_points == 1 ? 4 : 2;
 
-        u32* num_verts = &lines->backend->num_verts;
+    _lines_write_points(lines, start, size, padded);
+}
 
-        // These will not always be filled the same amount
-        line_vert new_verts[6];
-        u32 new_indices[6];
-        line_corner new_corners[2];
+void draw_lines_add_points(draw_lines* lines, const vec2f* points, u32 num_points) {
+    if (lines == NULL || points == NULL) {
+        fprintf(stderr, "Cannot add points: lines or points is NULL\n");
+        return;
+    }
 
-        // Points
-        vec2f p0, p1, p2;
-        // Lines and normals
-        vec2f l1, n1, l2, n2;
+    if (lines->points.sealed) {
+        fprintf(stderr, "Cannot add points to sealed lines\n");
+        return;
+    }
 
-        f32 half_w = lines->width * 0.5f;
+    if (num_points == 0) {
+        return;
+    }
 
-        p0 = last_points[0];
-        p1 = last_points[1];
-        p2 = last_points[2];
+    rectf old_box = lines->bounding_box;
+    b32 old_empty = lines->points.size == 0;
+    u32 first = lines->points.size;
 
-        l1 = vec2f_nrm(vec2f_sub(p1, p0));
-        n1 = vec2f_prp(l1);
-        l2 = vec2f_nrm(vec2f_sub(p2, p1));
-        n2 = vec2f_prp(l2);
+    for (u32 i = 0; i < num_points; i++) {
+        draw_point_list_add(&lines->points, points[i]);
+        _lines_box_add(lines, points[i]);
+    }
 
-        // Avoiding issues with infinite miter projection
-        vec2f line_sum = vec2f_add(l1, l2);
-        vec2f tangent, miter;
-        f32 miter_scale;
-        if (vec2f_sqr_len(line_sum) < TANGENT_EPSILON) {
-            tangent = l1;
-            miter = n1;
-            miter_scale = 1.0f;
-        } else {
-            tangent = vec2f_nrm(vec2f_add(l1, l2));
-            miter = vec2f_prp(tangent);
-            miter_scale = 1.0f / vec2f_dot(miter, n1);
-        }
+    if (lines->index != NULL) {
+        draw_index_update(lines->index, lines, old_box, old_empty);
+    }
 
-        f32 line_cross = vec2f_crs(vec2f_sub(p1, p0), vec2f_sub(p2, p1));
-        // Some corner operations depend on which side of the points p1 is on
-        f32 s = -SIGN(line_cross);
+    u32 total_points = lines->points.size;
 
-        if (miter_scale < MITER_LIMIT && vec2f_sqr_len(line_sum) > TANGENT_EPSILON) {
-            new_verts[(*num_verts)++ - start_verts] = (line_vert){
-                vec2f_sub(p1, vec2f_scl(miter, half_w * miter_scale))
-            };
-            new_verts[(*num_verts)++ - start_verts] = (line_vert){
-                vec2f_add(p1, vec2f_scl(miter, half_w * miter_scale))
-            };
+    _lines_resize_point_buffer(lines, total_points);
 
-            new_indices[0] = start_verts + 0;
-            new_indices[1] = start_verts + 1;
-            new_indices[2] = start_verts + 2;
+    // Everything from the first new point to the end of the padding, with the first point
+    // repeated at the start if the lines were empty
+    u32 start = first == 0 ? 0 : first + 1;
+    u32 size = _padded_size(total_points) - start;
 
-            new_indices[3] = start_verts + 1;
-            new_indices[4] = start_verts + 3;
-            new_indices[5] = start_verts + 2;
-        } else {
-            new_corners[lines->backend->num_corners++ - start_corners] = (line_corner){
-                p0, p1, p2
-            };
+    mga_temp scratch = mga_scratch_get(NULL, 0);
 
-            // Point in the middle of line 1
-            vec2f l1_p = vec2f_add(
-                vec2f_sub(p1, vec2f_scl(miter, s * half_w * miter_scale)),
-                vec2f_scl(n1, s * half_w)
-            );
-            // Point in the middle of line 2
-            vec2f l2_p = vec2f_add(
-                vec2f_sub(p1, vec2f_scl(miter, s * half_w * miter_scale)),
-                vec2f_scl(n2, s * half_w)
-            );
-
-            // Getting parametric values for the line points
-            vec2f l1_vec = vec2f_sub(p1, p0);
-            f32 t1_unclamped = vec2f_dot(vec2f_sub(l1_p, p0), l1_vec) / vec2f_dot(l1_vec, l1_vec);
-            f32 t1 = CLAMP(t1_unclamped, 0, 1);
-
-            vec2f l2_vec = vec2f_sub(p1, p2);
-            f32 t2_unclamped = vec2f_dot(vec2f_sub(l2_p, p2), l2_vec) / vec2f_dot(l2_vec, l2_vec);
-            f32 t2 = CLAMP(t2_unclamped, 0, 1);
-
-            l1_p = vec2f_add(vec2f_scl(l1_vec, t1), p0);
-            l2_p = vec2f_add(vec2f_scl(l2_vec, t2), p2);
-
-            if (s == 1.0f) {
-                new_verts[(*num_verts)++ - start_verts] = (line_vert){ vec2f_sub(l1_p, vec2f_scl(n1, s * half_w)) };
-                new_verts[(*num_verts)++ - start_verts] = (line_vert){ vec2f_add(l1_p, vec2f_scl(n1, s * half_w)) };
-                new_verts[(*num_verts)++ - start_verts] = (line_vert){ vec2f_sub(l2_p, vec2f_scl(n2, s * half_w)) };
-                new_verts[(*num_verts)++ - start_verts] = (line_vert){ vec2f_add(l2_p, vec2f_scl(n2, s * half_w)) };
-            } else {
-                new_verts[(*num_verts)++ - start_verts] = (line_vert){ vec2f_add(l1_p, vec2f_scl(n1, s * half_w)) };
-                new_verts[(*num_verts)++ - start_verts] = (line_vert){ vec2f_sub(l1_p, vec2f_scl(n1, s * half_w)) };
-                new_verts[(*num_verts)++ - start_verts] = (line_vert){ vec2f_add(l2_p, vec2f_scl(n2, s * half_w)) };
-                new_verts[(*num_verts)++ - start_verts] = (line_vert){ vec2f_sub(l2_p, vec2f_scl(n2, s * half_w)) };
-            }
+    vec2f* padded = MGA_PUSH_ARRAY(scratch.arena, vec2f, size);
 
-            new_indices[0] = start_verts + 2;
-            new_indices[1] = start_verts + 3;
-            new_indices[2] = start_verts + 4;
+    if (first == 0) {
+        _pad_points(points, num_points, padded);
+    } else {
+        memcpy(padded, points, sizeof(vec2f) * num_points);
 
-            new_indices[3] = start_verts + 3;
-            new_indices[4] = start_verts + 5;
-            new_indices[5] = start_verts + 4;
+        for (u32 i = num_points; i < size; i++) {
+            padded[i] = points[num_points - 1];
         }
+    }
 
-        new_corners[lines->backend->num_corners++ - start_corners] = (line_corner){
-            p1, p2, p1
-        };
-
-        new_verts[(*num_verts)++ - start_verts] = (line_vert){ vec2f_sub(p2, vec2f_scl(n2, half_w)) };
-        new_verts[(*num_verts)++ - start_verts] = (line_vert){ vec2f_add(p2, vec2f_scl(n2, half_w)) };
-
-        _maybe_resize_buffer(
-            GL_ARRAY_BUFFER, sizeof(line_vert), lines->backend->num_verts,
-            &lines->backend->vert_capacity, &lines->backend->vert_buffer
-        );
-        _maybe_resize_buffer(
-            GL_ELEMENT_ARRAY_BUFFER, sizeof(u32), lines->backend->num_indices,
-            &lines->backend->index_capacity, &lines->backend->index_buffer
-        );
-        _maybe_resize_buffer(
-            GL_ARRAY_BUFFER, sizeof(line_corner), lines->backend->num_corners,
-            &lines->backend->corner_capacity, &lines->backend->corner_buffer
-        );
+    _lines_write_points(lines, start, size, padded);
 
-        glBindBuffer(GL_ARRAY_BUFFER, lines->backend->vert_buffer);
-        glBufferSubData(
-            GL_ARRAY_BUFFER, sizeof(line_vert) * start_verts,
-            sizeof(line_vert) * (lines->backend->num_verts - start_verts), new_verts
-        );
+    mga_scratch_release(scratch);
+}
 
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, lines->backend->index_buffer);
-        glBufferSubData(
-            GL_ELEMENT_ARRAY_BUFFER, sizeof(u32) * start_indices,
-            sizeof(u32) * (lines->backend->num_indices - start_indices), new_indices
-        );
+// Range of the point buffer that changed since the stream of the lines last wrote it, returns its size
+u32 _lines_dirty_points(const draw_lines* lines, u32* first, u32* buffer) {
+    *first = lines->backend->dirty_first;
+    *buffer = lines->backend->point_buffer;
 
-        glBindBuffer(GL_ARRAY_BUFFER, lines->backend->corner_buffer);
-        glBufferSubData(
-            GL_ARRAY_BUFFER, sizeof(line_corner) * start_corners,
-            sizeof(line_corner) * (lines->backend->num_corners - start_corners), new_corners
-        );
+    return lines->backend->dirty_end - lines->backend->dirty_first;
+}
+// Writes the padded points of that range to out and marks it as written
+void _lines_take_dirty(draw_lines* lines, vec2f* out) {
+    draw_lines_backend* backend = lines->backend;
+    u32 num_points = lines->points.size;
+
+    // Same layout as _pad_points
+    for (u32 i = backend->dirty_first; i < backend->dirty_end; i++) {
+        u32 index = i == 0 ? 0 : MIN(i - 1, num_points - 1);
+        out[i - backend->dirty_first] = draw_point_list_get(&lines->points, index);
     }
+
+    backend->dirty_end = backend->dirty_first;
 }
 
 void _maybe_resize_buffer(u32 type, u32 elem_size, u32 size, u32* capacity, u32* buffer) {
@@ -861,15 +700,17 @@ void _maybe_resize_buffer(u32 type, u32 elem_size, u32 size, u32* capacity, u32*
         u32 old_capacity = *capacity;
 
         // TODO: is 2 better? add options?
-        *capacity *= 1.5;
+        // Lines made with draw_lines_from_points start out with an exact fit,
+        // so a single step can be more than 1.5x
+        *capacity = MAX(size, (u32)(*capacity * 1.5));
 
         u32 new_buffer = glh_create_buffer(type, *capacity * elem_size, NULL, GL_DYNAMIC_DRAW);
 
-        glBindBuffer(GL_COPY_READ_BUFFER, *buffer);
-        glBindBuffer(GL_COPY_WRITE_BUFFER, new_buffer);
+        glh_bind_buffer(GL_COPY_READ_BUFFER, *buffer);
+        glh_bind_buffer(GL_COPY_WRITE_BUFFER, new_buffer);
         glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, old_capacity * elem_size);
 
-        glDeleteBuffers(1, buffer);
+        glh_delete_buffers(1, buffer);
 
         *buffer = new_buffer;
     }
@@ -893,41 +734,87 @@ b32 draw_lines_collide_circle(draw_lines* lines, circlef circle) {
     }
 
     if (lines->points.size == 1 &&
-        vec2f_dist(lines->points.first->points[0], circle.pos) < lines->width + circle.r) {
+        vec2f_dist(draw_point_list_get(&lines->points, 0), circle.pos) < lines->width + circle.r) {
             return true;
     }
 
-    f32 dist_threshold = (lines->width * 0.5f + circle.r) * (lines->width * 0.5f + circle.r);
+    f32 radius = lines->width * 0.5f + circle.r;
+
+    // Buckets whose bounds are further than this from the circle cannot contain a hit
+    circlef bucket_circle = { circle.pos, radius };
 
-    vec2f p0, p1;
-    p1 = lines->points.first->points[0];
+    // Sealed points get decoded here one bucket at a time
+    vec2f scratch[DRAW_POINT_BUCKET_MAX_SIZE];
 
-    draw_point_bucket* cur_bucket = lines->points.first;
-    u32 cur_num_buckets = 0;
+    for (u32 i = 0; i < lines->points.num_buckets; i++) {
+        if (!rectf_collide_circlef(draw_point_list_bucket_bounds(&lines->points, i), bucket_circle)) {
+            continue;
+        }
 
-    for (u32 i = 0; i < lines->points.size - 1; i++) {
-        p0 = p1;
+        u32 num_points = 0;
+        const vec2f* points = draw_point_list_bucket_points(&lines->points, i, scratch, &num_points);
 
-        if (i + 1 >= (cur_num_buckets + 1) * DRAW_POINT_BUCKET_SIZE) {
-            if (cur_bucket->next == NULL) {
-                fprintf(stderr, "Cannot collide lines, not enough point buckets\n");
+        // The first segment of a bucket starts at the last point of the previous one
+        if (i > 0) {
+            vec2f joint[2] = {
+                draw_point_list_get(&lines->points, draw_point_list_bucket_start(i) - 1),
+                points[0]
+            };
 
-                return false;
+            if (draw_segments_collide_circle(joint, 2, circle.pos, radius)) {
+                return true;
             }
+        }
+
+        if (draw_segments_collide_circle(points, num_points, circle.pos, radius)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+b32 draw_lines_collide_capsule(draw_lines* lines, capsulef capsule) {
+    if (lines == NULL || lines->points.size == 0) {
+        fprintf(stderr, "Cannot collide capsule with lines: lines is NULL or has zero points\n");
+        return false;
+    }
+
+    if (!rectf_collide_capsulef(lines->bounding_box, capsule)) {
+        return false;
+    }
+
+    if (lines->points.size == 1) {
+        vec2f point = draw_point_list_get(&lines->points, 0);
+        return draw_segments_collide_capsule((vec2f[2]){ point, point }, 2, capsule.p0, capsule.p1, lines->width + capsule.r);
+    }
+
+    f32 radius = lines->width * 0.5f + capsule.r;
 
-            cur_bucket = cur_bucket->next;
-            cur_num_buckets++;
+    capsulef bucket_capsule = { capsule.p0, capsule.p1, radius };
+
+    vec2f scratch[DRAW_POINT_BUCKET_MAX_SIZE];
+
+    for (u32 i = 0; i < lines->points.num_buckets; i++) {
+        if (!rectf_collide_capsulef(draw_point_list_bucket_bounds(&lines->points, i), bucket_capsule)) {
+            continue;
         }
-        p1 = cur_bucket->points[i + 1 - cur_num_buckets * DRAW_POINT_BUCKET_SIZE];
 
-        vec2f line_vec = vec2f_sub(p1, p0);
-        vec2f point_vec = vec2f_sub(circle.pos, p0);
-        f32 t = vec2f_dot(point_vec, line_vec) / vec2f_dot(line_vec, line_vec);
-        t = CLAMP(t, 0, 1);
+        u32 num_points = 0;
+        const vec2f* points = draw_point_list_bucket_points(&lines->points, i, scratch, &num_points);
+
+        if (i > 0) {
+            vec2f joint[2] = {
+                draw_point_list_get(&lines->points, draw_point_list_bucket_start(i) - 1),
+                points[0]
+            };
 
-        f32 sqr_dist = vec2f_sqr_dist(point_vec, vec2f_scl(line_vec, t));
+            if (draw_segments_collide_capsule(joint, 2, capsule.p0, capsule.p1, radius)) {
+                return true;
+            }
+        }
 
-        if (sqr_dist < dist_threshold) {
+        if (draw_segments_collide_capsule(points, num_points, capsule.p0, capsule.p1, radius)) {
             return true;
         }
     }
@@ -935,18 +822,224 @@ b32 draw_lines_collide_circle(draw_lines* lines, circlef circle) {
     return false;
 }
 
+// Builds lines from points[first..last] of src. The points are copied from the point buffer of src,
+// only the repeated points at the new ends get written
+static draw_lines* _lines_from_range(mg_arena* arena, const draw_lines* src, const vec2f* points, u32 first, u32 last) {
+    u32 num_points = last - first + 1;
+
+    draw_lines* lines = MGA_PUSH_ZERO_STRUCT(arena, draw_lines);
+    lines->points = (draw_point_list){ .allocator = src->allocator };
+    lines->backend = MGA_PUSH_ZERO_STRUCT(arena, draw_lines_backend);
+
+    lines->color = src->color;
+    lines->width = src->width;
+    lines->allocator = src->allocator;
+
+    _lines_set_points(lines, points + first, num_points);
+
+    draw_lines_backend* backend = lines->backend;
+
+    backend->point_capacity = _padded_size(num_points);
+
+    glGenVertexArrays(1, &backend->segment_array);
+    glGenVertexArrays(1, &backend->corner_array);
+
+    backend->point_buffer = glh_create_buffer(
+        GL_ARRAY_BUFFER, sizeof(vec2f) * backend->point_capacity, NULL, GL_DYNAMIC_DRAW
+    );
+
+    // Point i is at i + 1 in both buffers
+    glh_bind_buffer(GL_COPY_READ_BUFFER, src->backend->point_buffer);
+    glh_bind_buffer(GL_COPY_WRITE_BUFFER, backend->point_buffer);
+    glCopyBufferSubData(
+        GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, sizeof(vec2f) * (first + 1),
+        sizeof(vec2f), sizeof(vec2f) * num_points
+    );
+
+    glh_bind_buffer(GL_ARRAY_BUFFER, backend->point_buffer);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vec2f), &points[first]);
+    glBufferSubData(GL_ARRAY_BUFFER, sizeof(vec2f) * (num_points + 1), sizeof(vec2f), &points[last]);
+
+    glh_bind_buffer(GL_ARRAY_BUFFER, 0);
+    glh_bind_buffer(GL_COPY_READ_BUFFER, 0);
+    glh_bind_buffer(GL_COPY_WRITE_BUFFER, 0);
+
+    return lines;
+}
+
+b32 draw_lines_split_capsule(mg_arena* arena, const draw_lines* lines, capsulef capsule, draw_lines** pieces, u32* num_pieces) {
+    if (lines == NULL || pieces == NULL || num_pieces == NULL || lines->points.size == 0) {
+        fprintf(stderr, "Cannot split lines: lines or output is NULL or lines has zero points\n");
+        return false;
+    }
+
+    *num_pieces = 0;
+
+    if (!rectf_collide_capsulef(lines->bounding_box, capsule)) {
+        return false;
+    }
+
+    u32 num_points = lines->points.size;
+
+    if (num_points == 1) {
+        // A dot is either erased completely or not at all
+        vec2f point = draw_point_list_get(&lines->points, 0);
+        return draw_segments_collide_capsule((vec2f[2]){ point, point }, 2, capsule.p0, capsule.p1, lines->width + capsule.r);
+    }
+
+    mga_temp scratch = mga_scratch_get(NULL, 0);
+
+    vec2f* points = MGA_PUSH_ARRAY(scratch.arena, vec2f, num_points);
+    b8* hits = MGA_PUSH_ZERO_ARRAY(scratch.arena, b8, num_points - 1);
+
+    draw_point_list_copy(&lines->points, points);
+
+    f32 radius = lines->width * 0.5f + capsule.r;
+    capsulef bucket_capsule = { capsule.p0, capsule.p1, radius };
+
+    b32 any_hit = false;
+
+    for (u32 i = 0; i < lines->points.num_buckets; i++) {
+        if (!rectf_collide_capsulef(draw_point_list_bucket_bounds(&lines->points, i), bucket_capsule)) {
+            continue;
+        }
+
+        // Segments ending in this bucket, including the one from the previous bucket
+        u32 start = draw_point_list_bucket_start(i);
+        u32 first = i > 0 ? start - 1 : start;
+        u32 end = i + 1 < lines->points.num_buckets ? draw_point_list_bucket_start(i + 1) : num_points;
+
+        draw_segments_hit_capsule(points + first, end - first, capsule.p0, capsule.p1, radius, hits + first);
+
+        for (u32 j = first; j + 1 < end && !any_hit; j++) {
+            any_hit = hits[j];
+        }
+    }
+
+    if (!any_hit) {
+        mga_scratch_release(scratch);
+        return false;
+    }
+
+    u32 piece_first = 0;
+
+    for (u32 i = 0; i < num_points; i++) {
+        b32 kept_before = i > 0 && !hits[i - 1];
+        b32 kept_after = i + 1 < num_points && !hits[i];
+
+        if (kept_before && !kept_after) {
+            pieces[(*num_pieces)++] = _lines_from_range(arena, lines, points, piece_first, i);
+        }
+
+        if (kept_after && !kept_before) {
+            piece_first = i;
+        }
+    }
+
+    mga_scratch_release(scratch);
+
+    return true;
+}
+
 static const char* line_seg_vert = GLSL_SOURCE(
     330,
-    
-    layout (location = 0) in vec2 a_pos;
+
+    // The segment goes from a_p1 to a_p2, a_p0 and a_p3 are the points around it
+    layout (location = 0) in vec2 a_p0;
+    layout (location = 1) in vec2 a_p1;
+    layout (location = 2) in vec2 a_p2;
+    layout (location = 3) in vec2 a_p3;
+
     out float side;
 
+    uniform float u_line_width;
+    uniform int u_num_points;
     uniform mat3 u_view_mat;
 
+    // Returns length of z component
+    float crs(vec2 a, vec2 b) {
+        return a.x * b.y - a.y * b.x;
+    }
+
+    // Middle and half of the vertex pair where a segment meets the joint p0 -> p1 -> p2.
+    // into_joint is 1 for the segment from p0 and 0 for the segment to p2.
+    // Joints get mitered, corners cut both segments short and leave the rest to the corner shader
+    void joint(vec2 p0, vec2 p1, vec2 p2, int into_joint, out vec2 mid, out vec2 offset) {
+        float half_w = u_line_width * 0.5;
+
+        vec2 l1 = normalize(p1 - p0);
+        vec2 n1 = vec2(-l1.y, l1.x);
+        vec2 l2 = normalize(p2 - p1);
+        vec2 n2 = vec2(-l2.y, l2.x);
+
+        // Avoiding issues with infinite miter projection
+        vec2 line_sum = l1 + l2;
+        vec2 miter;
+        float miter_scale;
+        if (dot(line_sum, line_sum) < TANGENT_EPSILON) {
+            miter = n1;
+            miter_scale = 1.0;
+        } else {
+            vec2 tangent = normalize(line_sum);
+            miter = vec2(-tangent.y, tangent.x);
+            miter_scale = 1.0 / dot(miter, n1);
+        }
+
+        // Negated corner test, repeated points give NaNs that have to count the same way
+        if (!(miter_scale >= MITER_LIMIT || dot(line_sum, line_sum) <= TANGENT_EPSILON)) {
+            mid = p1;
+            offset = miter * (half_w * miter_scale);
+
+            return;
+        }
+
+        // Some corner operations depend on which side of the points p1 is on
+        float s = -sign(crs(p1 - p0, p2 - p1));
+        vec2 inner = p1 - miter * (s * half_w * miter_scale);
+
+        // Getting parametric values for the line points
+        if (into_joint == 1) {
+            vec2 l1_vec = p1 - p0;
+            float t1 = clamp(dot(inner + n1 * (s * half_w) - p0, l1_vec) / dot(l1_vec, l1_vec), 0.0, 1.0);
+
+            mid = p0 + l1_vec * t1;
+            offset = n1 * half_w;
+        } else {
+            vec2 l2_vec = p1 - p2;
+            float t2 = clamp(dot(inner + n2 * (s * half_w) - p2, l2_vec) / dot(l2_vec, l2_vec), 0.0, 1.0);
+
+            mid = p2 + l2_vec * t2;
+            offset = n2 * half_w;
+        }
+    }
+
     void main() {
+        // Vertices 0 and 1 are at the start, 2 and 3 at the end
         side = (float(gl_VertexID % 2) - 0.5) * 2.0;
 
-        vec2 pos = (u_view_mat * vec3(a_pos, 1.0)).xy;
+        vec2 l = normalize(a_p2 - a_p1);
+        vec2 n = vec2(-l.y, l.x);
+
+        vec2 mid;
+        vec2 offset;
+
+        if (gl_VertexID < 2) {
+            if (gl_InstanceID == 0) {
+                mid = a_p1;
+                offset = n * (u_line_width * 0.5);
+            } else {
+                joint(a_p0, a_p1, a_p2, 0, mid, offset);
+            }
+        } else {
+            if (gl_InstanceID == u_num_points - 2) {
+                mid = a_p2;
+                offset = n * (u_line_width * 0.5);
+            } else {
+                joint(a_p1, a_p2, a_p3, 1, mid, offset);
+            }
+        }
+
+        vec2 pos = (u_view_mat * vec3(mid + offset * side, 1.0)).xy;
         gl_Position = vec4(pos, 0.0, 1.0);
     }
 );
@@ -982,6 +1075,7 @@ static const char* corner_vert = GLSL_SOURCE(
     flat out vec2 p2;
 
     uniform float u_line_width;
+    uniform int u_num_points;
     uniform mat3 u_view_mat;
     uniform vec2 u_screen;
 
@@ -995,6 +1089,17 @@ static const char* corner_vert = GLSL_SOURCE(
         p1 = a_p1;
         p2 = a_p2;
 
+        if (u_num_points == 1) {
+            // Two caps facing away from each other form a circle
+            p0 = p1 + vec2(gl_InstanceID == 0 ? u_line_width * 1.1 : -u_line_width * 1.1, 0.0);
+            p2 = p0;
+        } else if (gl_InstanceID == 0) {
+            // Rounded line caps, the windows at the ends contain a repeated point
+            p0 = p2;
+        } else if (gl_InstanceID == u_num_points - 1) {
+            p2 = p0;
+        }
+
         vec2 l1 = normalize(p1 - p0);
         vec2 n1 = vec2(-l1.y, l1.x);
         vec2 l2 = normalize(p2 - p1);
@@ -1014,6 +1119,13 @@ static const char* corner_vert = GLSL_SOURCE(
             miter_scale = 1.0 / dot(miter, n1);
         }
 
+        // Mitered joints are covered by the segments
+        if (!(miter_scale >= MITER_LIMIT || dot(line_sum, line_sum) <= TANGENT_EPSILON)) {
+            pos = p1;
+            gl_Position = vec4(0.0, 0.0, 0.0, 1.0);
+
+            return;
+        }
 
         float half_w = u_line_width * 0.5;
         float s = -sign(crs(p1 - p0, p2 - p1));
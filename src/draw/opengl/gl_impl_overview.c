@@ -0,0 +1,319 @@
+#include "draw/draw.h"
+
+#ifdef DRAW_BACKEND_OPENGL
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "gfx/opengl/opengl.h"
+#include "gfx/opengl/opengl_helpers.h"
+
+// Texels per side of the base level
+#define OVERVIEW_SIZE 2048
+// Changed rects kept apart before they get merged into one
+#define OVERVIEW_MAX_DIRTY 16
+// Texels rendered again around a changed rect, the smoothed edges of lines reach past their bounding box
+#define OVERVIEW_PAD_PX 4.0f
+
+// Defined in gl_impl_batch.c
+void _batch_split_lines(
+    const draw_batch* batch, draw_lines** lines, u32 num_lines, mg_arena* arena,
+    draw_lines*** batched, u32* num_batched, draw_lines*** others, u32* num_others
+);
+
+typedef struct draw_overview {
+    // Union of everything invalidated so far
+    b32 has_bounds;
+    rectf bounds;
+
+    // The texture covers the square of OVERVIEW_SIZE texels around center.
+    // Texels are a power of two in world units, so that the square only changes by doubling
+    vec2f center;
+    f32 texel_size;
+
+    // In world units
+    rectf dirty[OVERVIEW_MAX_DIRTY];
+    u32 num_dirty;
+
+    u32 texture;
+    u32 framebuffer;
+
+    u32 program;
+    u32 view_mat_loc;
+    u32 rect_loc;
+    u32 texture_loc;
+
+    // Empty, the quad comes from the vertex ids
+    u32 vertex_array;
+} draw_overview;
+
+static const char* overview_vert;
+static const char* overview_frag;
+
+draw_overview* draw_overview_create(mg_arena* arena) {
+    draw_overview* overview = MGA_PUSH_ZERO_STRUCT(arena, draw_overview);
+
+    // Premultiplied colors, like the tiles of gl_impl_tiles.c
+    glGenTextures(1, &overview->texture);
+    glBindTexture(GL_TEXTURE_2D, overview->texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, OVERVIEW_SIZE, OVERVIEW_SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenFramebuffers(1, &overview->framebuffer);
+
+    overview->program = glh_create_shader(overview_vert, overview_frag);
+
+    glh_use_program(overview->program);
+    overview->view_mat_loc = glGetUniformLocation(overview->program, "u_view_mat");
+    overview->rect_loc = glGetUniformLocation(overview->program, "u_rect");
+    overview->texture_loc = glGetUniformLocation(overview->program, "u_texture");
+    glh_use_program(0);
+
+    glGenVertexArrays(1, &overview->vertex_array);
+
+    return overview;
+}
+void draw_overview_destroy(draw_overview* overview) {
+    if (overview == NULL) {
+        fprintf(stderr, "Cannot destroy overview: overview is NULL\n");
+        return;
+    }
+
+    glDeleteTextures(1, &overview->texture);
+    glDeleteFramebuffers(1, &overview->framebuffer);
+    glh_delete_program(overview->program);
+    glh_delete_vertex_arrays(1, &overview->vertex_array);
+}
+
+static rectf _overview_rect(const draw_overview* overview) {
+    f32 size = OVERVIEW_SIZE * overview->texel_size;
+
+    return (rectf){ overview->center.x - size * 0.5f, overview->center.y - size * 0.5f, size, size };
+}
+
+static b32 _overview_contains(const draw_overview* overview, rectf rect) {
+    rectf covered = _overview_rect(overview);
+
+    return rect.x >= covered.x && rect.y >= covered.y &&
+        rect.x + rect.w <= covered.x + covered.w && rect.y + rect.h <= covered.y + covered.h;
+}
+
+void draw_overview_invalidate(draw_overview* overview, rectf rect) {
+    if (overview == NULL) {
+        fprintf(stderr, "Cannot invalidate overview: overview is NULL\n");
+        return;
+    }
+
+    overview->bounds = overview->has_bounds ? rectf_union(overview->bounds, rect) : rect;
+
+    if (!overview->has_bounds || !_overview_contains(overview, rect)) {
+        // Centered on everything so far, with the smallest texels that still fit it
+        rectf bounds = overview->bounds;
+        f32 size = MAX(MAX(bounds.w, bounds.h), 1e-3f);
+
+        overview->center = (vec2f){ bounds.x + bounds.w * 0.5f, bounds.y + bounds.h * 0.5f };
+        overview->texel_size = exp2f(ceilf(log2f(size / OVERVIEW_SIZE)));
+        overview->has_bounds = true;
+
+        overview->dirty[0] = _overview_rect(overview);
+        overview->num_dirty = 1;
+
+        return;
+    }
+
+    if (overview->num_dirty == OVERVIEW_MAX_DIRTY) {
+        for (u32 i = 1; i < overview->num_dirty; i++) {
+            overview->dirty[0] = rectf_union(overview->dirty[0], overview->dirty[i]);
+        }
+
+        overview->num_dirty = 1;
+    }
+
+    overview->dirty[overview->num_dirty++] = rect;
+}
+
+// Renders the changed rects again and rebuilds the mipmaps
+static void _overview_render_dirty(
+    draw_overview* overview, draw_batch* batch, draw_lines** lines, u32 num_lines,
+    const draw_lines_shaders* shaders
+) {
+    i32 prev_framebuffer = 0;
+    i32 prev_viewport[4] = { 0 };
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &prev_framebuffer);
+    glGetIntegerv(GL_VIEWPORT, prev_viewport);
+
+    // The scissor rect of the screen gets replaced by the one of each rect
+    b32 prev_scissor = glIsEnabled(GL_SCISSOR_TEST);
+    i32 prev_scissor_box[4] = { 0 };
+    glGetIntegerv(GL_SCISSOR_BOX, prev_scissor_box);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, overview->framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, overview->texture, 0);
+
+    glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    glEnable(GL_SCISSOR_TEST);
+
+    rectf covered = _overview_rect(overview);
+    f32 texel = overview->texel_size;
+    f32 pad = OVERVIEW_PAD_PX * texel;
+
+    for (u32 i = 0; i < overview->num_dirty; i++) {
+        rectf rect = overview->dirty[i];
+
+        // Texels from the top left of the texture, the rows follow world y down
+        i32 x0 = (i32)CLAMP(floorf((rect.x - pad - covered.x) / texel), 0.0f, (f32)OVERVIEW_SIZE);
+        i32 y0 = (i32)CLAMP(floorf((rect.y - pad - covered.y) / texel), 0.0f, (f32)OVERVIEW_SIZE);
+        i32 x1 = (i32)CLAMP(ceilf((rect.x + rect.w + pad - covered.x) / texel), 0.0f, (f32)OVERVIEW_SIZE);
+        i32 y1 = (i32)CLAMP(ceilf((rect.y + rect.h + pad - covered.y) / texel), 0.0f, (f32)OVERVIEW_SIZE);
+
+        if (x1 <= x0 || y1 <= y0) {
+            continue;
+        }
+
+        u32 w = x1 - x0;
+        u32 h = y1 - y0;
+
+        // GL rows start at the bottom
+        glViewport(x0, OVERVIEW_SIZE - y1, w, h);
+        glScissor(x0, OVERVIEW_SIZE - y1, w, h);
+
+        f32 clear_col[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        glClearBufferfv(GL_COLOR, 0, clear_col);
+
+        viewf region_view = {
+            .center = { covered.x + (x0 + x1) * 0.5f * texel, covered.y + (y0 + y1) * 0.5f * texel },
+            .aspect_ratio = (f32)w / (f32)h,
+            .width = w * texel,
+            .rotation = 0.0f
+        };
+        gfx_window region_win = { .width = w, .height = h };
+
+        draw_batch_draw(batch, lines, num_lines, shaders, &region_win, region_view);
+    }
+
+    overview->num_dirty = 0;
+
+    glScissor(prev_scissor_box[0], prev_scissor_box[1], prev_scissor_box[2], prev_scissor_box[3]);
+    if (!prev_scissor) {
+        glDisable(GL_SCISSOR_TEST);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, prev_framebuffer);
+    glViewport(prev_viewport[0], prev_viewport[1], prev_viewport[2], prev_viewport[3]);
+
+    glBindTexture(GL_TEXTURE_2D, overview->texture);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+b32 draw_overview_draw(
+    draw_overview* overview, draw_batch* batch, draw_lines** lines, u32 num_lines,
+    const draw_lines_shaders* shaders, const gfx_window* win, viewf view, f32 max_screen_size
+) {
+    if (overview == NULL || batch == NULL) {
+        fprintf(stderr, "Cannot draw overview: overview or batch is NULL\n");
+        return false;
+    }
+
+    if (!overview->has_bounds || win->width == 0 || win->height == 0) {
+        return false;
+    }
+
+    f32 pixel_size = view.width / (f32)win->width;
+    f32 screen_size = MAX(overview->bounds.w, overview->bounds.h) / pixel_size;
+
+    // The texture never gets magnified
+    if (screen_size >= max_screen_size || pixel_size < overview->texel_size) {
+        return false;
+    }
+
+    mga_temp scratch = mga_scratch_get(NULL, 0);
+
+    draw_lines** batched = NULL;
+    u32 num_batched = 0;
+    draw_lines** others = NULL;
+    u32 num_others = 0;
+    _batch_split_lines(batch, lines, num_lines, scratch.arena, &batched, &num_batched, &others, &num_others);
+
+    if (overview->num_dirty > 0) {
+        _overview_render_dirty(overview, batch, batched, num_batched, shaders);
+    }
+
+    mat3f view_mat = { 0 };
+    mat3f_from_view(&view_mat, view);
+
+    rectf covered = _overview_rect(overview);
+
+    glh_use_program(overview->program);
+    glUniformMatrix3fv(overview->view_mat_loc, 1, GL_FALSE, view_mat.m);
+    glUniform4f(overview->rect_loc, covered.x, covered.y, covered.w, covered.h);
+    glUniform1i(overview->texture_loc, 0);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, overview->texture);
+
+    glh_bind_vertex_array(overview->vertex_array);
+
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    // Back to the blending everything else is drawn with
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    glh_bind_vertex_array(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glh_use_program(0);
+
+    rectf bounds = viewf_bounds(view);
+
+    for (u32 i = 0; i < num_others; i++) {
+        if (rectf_collide_rectf(others[i]->bounding_box, bounds)) {
+            draw_lines_draw(others[i], shaders, win, view);
+        }
+    }
+
+    mga_scratch_release(scratch);
+
+    return true;
+}
+
+static const char* overview_vert = GLSL_SOURCE(
+    330,
+
+    out vec2 uv;
+
+    uniform mat3 u_view_mat;
+    uniform vec4 u_rect;
+
+    void main() {
+        // Corners of the quad in strip order
+        vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1));
+        vec2 pos = u_rect.xy + corner * u_rect.zw;
+
+        // Rendered with world y pointing down, so the texture is upside down
+        uv = vec2(corner.x, 1.0 - corner.y);
+
+        gl_Position = vec4((u_view_mat * vec3(pos, 1.0)).xy, 0.0, 1.0);
+    }
+);
+
+static const char* overview_frag = GLSL_SOURCE(
+    330,
+
+    in vec2 uv;
+
+    layout (location = 0) out vec4 out_col;
+
+    uniform sampler2D u_texture;
+
+    void main() {
+        out_col = texture(u_texture, uv);
+    }
+);
+
+#endif // DRAW_BACKEND_OPENGL
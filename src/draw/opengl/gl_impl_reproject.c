@@ -0,0 +1,462 @@
+#include "draw/draw.h"
+
+#ifdef DRAW_BACKEND_OPENGL
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "gfx/opengl/opengl.h"
+#include "gfx/opengl/opengl_helpers.h"
+
+// Zooms further than this from the texture they start from draw everything again instead
+#define REPROJECT_MAX_SCALE 2.0f
+
+// Defined in gl_impl_batch.c
+void _batch_split_lines(
+    const draw_batch* batch, draw_lines** lines, u32 num_lines, mg_arena* arena,
+    draw_lines*** batched, u32* num_batched, draw_lines*** others, u32* num_others
+);
+
+typedef struct draw_reproject {
+    u32 width;
+    u32 height;
+
+    // The last frame is in textures[current], the next one gets drawn into the other
+    u32 textures[2];
+    u32 framebuffers[2];
+    u32 current;
+
+    // View the last frame was drawn with. During pans it is off by less than
+    // a pixel from the view on the screen, so that the texture moves by whole pixels
+    b32 valid;
+    viewf frame_view;
+    // Set once a zoom resampled the texture
+    b32 resampled;
+    // Texture of the last frame that was not resampled. Zooms resample it instead of
+    // the last frame, so that the errors do not pile up while the zoom goes on
+    b32 has_anchor;
+    u32 anchor;
+    viewf anchor_view;
+    // Set when lines on the screen joined or left the batch
+    b32 dirty;
+
+    // View of the last draw, the view stopped changing once it gets passed again
+    viewf prev_view;
+
+    u32 program;
+    u32 rect_loc;
+    u32 texture_loc;
+
+    // Empty, the quad comes from the vertex ids
+    u32 vertex_array;
+
+    draw_reproject_stats stats;
+} draw_reproject;
+
+static const char* reproject_vert;
+static const char* reproject_frag;
+
+draw_reproject* draw_reproject_create(mg_arena* arena) {
+    draw_reproject* reproject = MGA_PUSH_ZERO_STRUCT(arena, draw_reproject);
+
+    glGenFramebuffers(2, reproject->framebuffers);
+
+    reproject->program = glh_create_shader(reproject_vert, reproject_frag);
+
+    glh_use_program(reproject->program);
+    reproject->rect_loc = glGetUniformLocation(reproject->program, "u_rect");
+    reproject->texture_loc = glGetUniformLocation(reproject->program, "u_texture");
+    glh_use_program(0);
+
+    glGenVertexArrays(1, &reproject->vertex_array);
+
+    return reproject;
+}
+void draw_reproject_destroy(draw_reproject* reproject) {
+    if (reproject == NULL) {
+        fprintf(stderr, "Cannot destroy reproject: reproject is NULL\n");
+        return;
+    }
+
+    if (reproject->width > 0) {
+        glDeleteTextures(2, reproject->textures);
+    }
+    glDeleteFramebuffers(2, reproject->framebuffers);
+    glh_delete_program(reproject->program);
+    glh_delete_vertex_arrays(1, &reproject->vertex_array);
+}
+
+void draw_reproject_invalidate(draw_reproject* reproject, rectf rect) {
+    if (reproject == NULL) {
+        fprintf(stderr, "Cannot invalidate reproject: reproject is NULL\n");
+        return;
+    }
+
+    if (reproject->valid && rectf_collide_rectf(rect, viewf_bounds(reproject->frame_view))) {
+        reproject->dirty = true;
+    }
+    // Zooms out of the anchor would show it again
+    if (reproject->has_anchor && rectf_collide_rectf(rect, viewf_bounds(reproject->anchor_view))) {
+        reproject->dirty = true;
+    }
+}
+
+// Premultiplied colors, like the tiles of gl_impl_tiles.c
+static void _reproject_resize(draw_reproject* reproject, u32 width, u32 height) {
+    if (reproject->width > 0) {
+        glDeleteTextures(2, reproject->textures);
+    }
+
+    glGenTextures(2, reproject->textures);
+
+    i32 prev_framebuffer = 0;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &prev_framebuffer);
+
+    for (u32 i = 0; i < 2; i++) {
+        glBindTexture(GL_TEXTURE_2D, reproject->textures[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, reproject->framebuffers[i]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, reproject->textures[i], 0);
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, prev_framebuffer);
+
+    reproject->width = width;
+    reproject->height = height;
+    reproject->valid = false;
+}
+
+static b32 _views_equal(viewf a, viewf b) {
+    return a.center.x == b.center.x && a.center.y == b.center.y && a.width == b.width &&
+        a.aspect_ratio == b.aspect_ratio && a.rotation == b.rotation;
+}
+
+// Draws the texture of from_view into the bound framebuffer, which shows to_view. Both views need the same rotation and aspect ratio
+static void _reproject_quad(const draw_reproject* reproject, u32 texture, viewf from_view, viewf to_view) {
+    mat3f to_mat = { 0 };
+    mat3f_from_view(&to_mat, to_view);
+
+    vec2f center = mat3f_mul_vec2f(&to_mat, from_view.center);
+    f32 scale = from_view.width / to_view.width;
+
+    glh_use_program(reproject->program);
+    glUniform4f(reproject->rect_loc, center.x - scale, center.y - scale, center.x + scale, center.y + scale);
+    glUniform1i(reproject->texture_loc, 0);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture);
+
+    glh_bind_vertex_array(reproject->vertex_array);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    glh_bind_vertex_array(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glh_use_program(0);
+}
+
+// Clears and draws the pixels from x, y (from the bottom left) of the bound framebuffer, which shows view
+static void _reproject_render(
+    draw_reproject* reproject, draw_batch* batch, draw_lines** lines, u32 num_lines,
+    const draw_lines_shaders* shaders, viewf view, u32 x, u32 y, u32 w, u32 h
+) {
+    if (w == 0 || h == 0) {
+        return;
+    }
+
+    glViewport(x, y, w, h);
+    glScissor(x, y, w, h);
+
+    f32 clear_col[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    glClearBufferfv(GL_COLOR, 0, clear_col);
+
+    // Same scale and rotation, only showing the part of view in the rect
+    viewf part_view = view;
+    gfx_window part_win = { .width = w, .height = h };
+
+    if (w != reproject->width || h != reproject->height) {
+        vec2f ndc_center = {
+            (x + w * 0.5f) / reproject->width * 2.0f - 1.0f,
+            (y + h * 0.5f) / reproject->height * 2.0f - 1.0f,
+        };
+
+        part_view.center = viewf_ndc_to_world(view, ndc_center);
+        part_view.aspect_ratio = (f32)w / (f32)h;
+        part_view.width = view.width * w / reproject->width;
+    }
+
+    draw_batch_draw(batch, lines, num_lines, shaders, &part_win, part_view);
+
+    reproject->stats.num_rendered_pixels += w * h;
+}
+
+// Moves the last frame into the other texture and draws the parts it does not cover.
+// Returns false if the zoom is too far or nothing is covered
+static b32 _reproject_move(
+    draw_reproject* reproject, draw_batch* batch, draw_lines** lines, u32 num_lines,
+    const draw_lines_shaders* shaders, viewf view
+) {
+    u32 width = reproject->width;
+    u32 height = reproject->height;
+
+    u32 source = reproject->current;
+    viewf frame_view = reproject->frame_view;
+
+    viewf next_view = view;
+    b32 pan = frame_view.width == view.width;
+
+    if (!pan) {
+        if (!reproject->resampled) {
+            reproject->has_anchor = true;
+            reproject->anchor = reproject->current;
+            reproject->anchor_view = reproject->frame_view;
+        }
+        if (reproject->has_anchor) {
+            source = reproject->anchor;
+            frame_view = reproject->anchor_view;
+        }
+
+        f32 scale = frame_view.width / view.width;
+        if (scale > REPROJECT_MAX_SCALE || scale < 1.0f / REPROJECT_MAX_SCALE) {
+            return false;
+        }
+    }
+
+    u32 next = 1 - source;
+
+    // Pixels the last frame covers completely in the next one
+    i32 x0 = 0;
+    i32 x1 = 0;
+    i32 y0 = 0;
+    i32 y1 = 0;
+
+    if (pan) {
+        // Moving the texture by whole pixels. The next frame shows the view off by the rest
+        mat3f view_mat = { 0 };
+        mat3f_from_view(&view_mat, view);
+
+        vec2f offset = mat3f_mul_vec2f(&view_mat, frame_view.center);
+        offset.x *= width * 0.5f;
+        offset.y *= height * 0.5f;
+
+        i32 dx = (i32)roundf(offset.x);
+        i32 dy = (i32)roundf(offset.y);
+
+        vec2f rest = {
+            (offset.x - dx) / (width * 0.5f),
+            (offset.y - dy) / (height * 0.5f),
+        };
+
+        next_view.center = viewf_ndc_to_world(view, rest);
+
+        x0 = CLAMP(dx, 0, (i32)width);
+        x1 = CLAMP((i32)width + dx, 0, (i32)width);
+        y0 = CLAMP(dy, 0, (i32)height);
+        y1 = CLAMP((i32)height + dy, 0, (i32)height);
+
+        if (x1 <= x0 || y1 <= y0) {
+            return false;
+        }
+
+        // A plain copy, the pixels do not change
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, reproject->framebuffers[source]);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, reproject->framebuffers[next]);
+        glBlitFramebuffer(x0 - dx, y0 - dy, x1 - dx, y1 - dy, x0, y0, x1, y1, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_FRAMEBUFFER, reproject->framebuffers[next]);
+    } else {
+        mat3f next_mat = { 0 };
+        mat3f_from_view(&next_mat, next_view);
+
+        vec2f center = mat3f_mul_vec2f(&next_mat, frame_view.center);
+        f32 scale = frame_view.width / next_view.width;
+
+        x0 = (i32)ceilf((center.x - scale + 1.0f) * 0.5f * width - 0.01f);
+        x1 = (i32)floorf((center.x + scale + 1.0f) * 0.5f * width + 0.01f);
+        y0 = (i32)ceilf((center.y - scale + 1.0f) * 0.5f * height - 0.01f);
+        y1 = (i32)floorf((center.y + scale + 1.0f) * 0.5f * height + 0.01f);
+
+        x0 = CLAMP(x0, 0, (i32)width);
+        x1 = CLAMP(x1, 0, (i32)width);
+        y0 = CLAMP(y0, 0, (i32)height);
+        y1 = CLAMP(y1, 0, (i32)height);
+
+        if (x1 <= x0 || y1 <= y0) {
+            return false;
+        }
+
+        glBindFramebuffer(GL_FRAMEBUFFER, reproject->framebuffers[next]);
+        glViewport(0, 0, width, height);
+
+        glDisable(GL_BLEND);
+        _reproject_quad(reproject, reproject->textures[source], frame_view, next_view);
+        glEnable(GL_BLEND);
+    }
+
+    glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    glEnable(GL_SCISSOR_TEST);
+
+    // Bottom and top across the whole width, left and right in between
+    _reproject_render(reproject, batch, lines, num_lines, shaders, next_view, 0, 0, width, y0);
+    _reproject_render(reproject, batch, lines, num_lines, shaders, next_view, 0, y1, width, height - y1);
+    _reproject_render(reproject, batch, lines, num_lines, shaders, next_view, 0, y0, x0, y1 - y0);
+    _reproject_render(reproject, batch, lines, num_lines, shaders, next_view, x1, y0, width - x1, y1 - y0);
+
+    glDisable(GL_SCISSOR_TEST);
+
+    reproject->current = next;
+    reproject->frame_view = next_view;
+    reproject->resampled |= !pan;
+
+    if (reproject->has_anchor && reproject->anchor == next) {
+        reproject->has_anchor = false;
+    }
+
+    return true;
+}
+
+void draw_reproject_draw(
+    draw_reproject* reproject, draw_batch* batch, draw_lines** lines, u32 num_lines,
+    const draw_lines_shaders* shaders, const gfx_window* win, viewf view
+) {
+    if (reproject == NULL || batch == NULL) {
+        fprintf(stderr, "Cannot draw reproject: reproject or batch is NULL\n");
+        return;
+    }
+
+    reproject->stats = (draw_reproject_stats){ 0 };
+
+    if (win->width == 0 || win->height == 0) {
+        return;
+    }
+
+    if (win->width != reproject->width || win->height != reproject->height) {
+        _reproject_resize(reproject, win->width, win->height);
+    }
+
+    mga_temp scratch = mga_scratch_get(NULL, 0);
+
+    draw_lines** batched = NULL;
+    u32 num_batched = 0;
+    draw_lines** others = NULL;
+    u32 num_others = 0;
+    _batch_split_lines(batch, lines, num_lines, scratch.arena, &batched, &num_batched, &others, &num_others);
+
+    viewf frame_view = reproject->frame_view;
+
+    b32 full = !reproject->valid || reproject->dirty ||
+        frame_view.rotation != view.rotation || frame_view.aspect_ratio != view.aspect_ratio;
+
+    // Once the view stops changing, the frame gets drawn again without the errors of moving it
+    if (_views_equal(view, reproject->prev_view) && (reproject->resampled || !_views_equal(view, frame_view))) {
+        full = true;
+    }
+
+    b32 changed = full || !_views_equal(view, frame_view);
+
+    i32 prev_framebuffer = 0;
+    i32 prev_viewport[4] = { 0 };
+    // The scissor rect of the screen would cut the copies and gets replaced by the ones of the exposed parts
+    b32 prev_scissor = false;
+    i32 prev_scissor_box[4] = { 0 };
+
+    if (changed) {
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &prev_framebuffer);
+        glGetIntegerv(GL_VIEWPORT, prev_viewport);
+        prev_scissor = glIsEnabled(GL_SCISSOR_TEST);
+        glGetIntegerv(GL_SCISSOR_BOX, prev_scissor_box);
+
+        glDisable(GL_SCISSOR_TEST);
+    }
+
+    if (!full && changed) {
+        full = !_reproject_move(reproject, batch, batched, num_batched, shaders, view);
+    }
+
+    if (full) {
+        glBindFramebuffer(GL_FRAMEBUFFER, reproject->framebuffers[reproject->current]);
+        glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+        glEnable(GL_SCISSOR_TEST);
+
+        _reproject_render(reproject, batch, batched, num_batched, shaders, view, 0, 0, reproject->width, reproject->height);
+
+        glDisable(GL_SCISSOR_TEST);
+
+        reproject->valid = true;
+        reproject->frame_view = view;
+        reproject->resampled = false;
+        reproject->has_anchor = false;
+        reproject->dirty = false;
+    }
+
+    if (changed) {
+        glBindFramebuffer(GL_FRAMEBUFFER, prev_framebuffer);
+        glViewport(prev_viewport[0], prev_viewport[1], prev_viewport[2], prev_viewport[3]);
+        glScissor(prev_scissor_box[0], prev_scissor_box[1], prev_scissor_box[2], prev_scissor_box[3]);
+
+        if (prev_scissor) {
+            glEnable(GL_SCISSOR_TEST);
+        }
+    }
+
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    _reproject_quad(reproject, reproject->textures[reproject->current], reproject->frame_view, view);
+    // Back to the blending everything else is drawn with
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    rectf bounds = viewf_bounds(view);
+
+    for (u32 i = 0; i < num_others; i++) {
+        if (rectf_collide_rectf(others[i]->bounding_box, bounds)) {
+            draw_lines_draw(others[i], shaders, win, view);
+        }
+    }
+
+    reproject->prev_view = view;
+
+    mga_scratch_release(scratch);
+}
+
+draw_reproject_stats draw_reproject_get_stats(const draw_reproject* reproject) {
+    return reproject->stats;
+}
+
+static const char* reproject_vert = GLSL_SOURCE(
+    330,
+
+    out vec2 uv;
+
+    // Corners of the quad in normalized device coordinates
+    uniform vec4 u_rect;
+
+    void main() {
+        // Corners of the quad in strip order
+        vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1));
+
+        // The texture and the screen both start at the bottom
+        uv = corner;
+
+        gl_Position = vec4(mix(u_rect.xy, u_rect.zw, corner), 0.0, 1.0);
+    }
+);
+
+static const char* reproject_frag = GLSL_SOURCE(
+    330,
+
+    in vec2 uv;
+
+    layout (location = 0) out vec4 out_col;
+
+    uniform sampler2D u_texture;
+
+    void main() {
+        out_col = texture(u_texture, uv);
+    }
+);
+
+#endif // DRAW_BACKEND_OPENGL
@@ -0,0 +1,280 @@
+#include "draw/draw.h"
+
+#ifdef DRAW_BACKEND_OPENGL
+
+#include <stdio.h>
+
+#include "gfx/opengl/opengl.h"
+#include "gfx/opengl/opengl_helpers.h"
+
+// Lines that can be in one stream at the same time
+#define STREAM_MAX_LINES 16
+// The ring is split into one section per flush, a section gets written again
+// once the GPU is done with the flush from STREAM_NUM_SECTIONS frames ago
+#define STREAM_NUM_SECTIONS 3
+#define STREAM_SECTION_SIZE (64 * 1024)
+// Nanoseconds to wait for a section before writing around the ring
+#define STREAM_WAIT_TIMEOUT 1000000000ull
+
+// Defined in gl_impl_lines.c
+u32 _lines_dirty_points(const draw_lines* lines, u32* first, u32* buffer);
+void _lines_take_dirty(draw_lines* lines, vec2f* out);
+
+typedef struct draw_stream {
+    // Persistently mapped where glBufferStorage is available, otherwise orphaned on every flush
+    b32 persistent;
+    u32 buffer;
+    u8* mapped;
+
+    GLsync fences[STREAM_NUM_SECTIONS];
+    u32 section;
+
+    draw_lines* lines[STREAM_MAX_LINES];
+    u32 num_lines;
+} draw_stream;
+
+typedef struct {
+    // Byte offset in the section and size
+    u32 offset;
+    u32 size;
+
+    // Destination, first is in points
+    u32 buffer;
+    u32 first;
+} _stream_copy;
+
+draw_stream* draw_stream_create(mg_arena* arena) {
+    draw_stream* stream = MGA_PUSH_ZERO_STRUCT(arena, draw_stream);
+
+    glGenBuffers(1, &stream->buffer);
+    glh_bind_buffer(GL_COPY_READ_BUFFER, stream->buffer);
+
+#ifndef PLATFORM_WASM
+    // WebGL 2 cannot map buffers
+    i32 major_version = 0;
+    i32 minor_version = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major_version);
+    glGetIntegerv(GL_MINOR_VERSION, &minor_version);
+
+    stream->persistent = major_version > 4 || (major_version == 4 && minor_version >= 4);
+
+    if (stream->persistent) {
+        u64 ring_size = (u64)STREAM_SECTION_SIZE * STREAM_NUM_SECTIONS;
+        u32 flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+        glBufferStorage(GL_COPY_READ_BUFFER, ring_size, NULL, flags);
+        stream->mapped = glMapBufferRange(GL_COPY_READ_BUFFER, 0, ring_size, flags);
+
+        if (stream->mapped == NULL) {
+            fprintf(stderr, "Cannot map stream buffer, falling back to orphaning\n");
+
+            // Immutable storage cannot be orphaned
+            glh_delete_buffers(1, &stream->buffer);
+            glGenBuffers(1, &stream->buffer);
+
+            stream->persistent = false;
+        }
+    }
+#endif
+
+    glh_bind_buffer(GL_COPY_READ_BUFFER, 0);
+
+    return stream;
+}
+void draw_stream_destroy(draw_stream* stream) {
+    if (stream == NULL) {
+        fprintf(stderr, "Cannot destroy stream: stream is NULL\n");
+        return;
+    }
+
+    while (stream->num_lines > 0) {
+        draw_stream_remove(stream, stream->lines[stream->num_lines - 1]);
+    }
+
+    for (u32 i = 0; i < STREAM_NUM_SECTIONS; i++) {
+        if (stream->fences[i] != NULL) {
+            glDeleteSync(stream->fences[i]);
+        }
+    }
+
+    // Deleting the buffer unmaps it
+    glh_delete_buffers(1, &stream->buffer);
+}
+
+void draw_stream_add(draw_stream* stream, draw_lines* lines) {
+    if (stream == NULL || lines == NULL) {
+        fprintf(stderr, "Cannot add lines to stream: stream or lines is NULL\n");
+        return;
+    }
+    if (lines->stream == stream) {
+        return;
+    }
+    if (lines->stream != NULL) {
+        fprintf(stderr, "Cannot add lines to stream: lines are already in a stream\n");
+        return;
+    }
+    if (stream->num_lines == STREAM_MAX_LINES) {
+        fprintf(stderr, "Cannot add lines to stream: stream is full\n");
+        return;
+    }
+
+    stream->lines[stream->num_lines++] = lines;
+    lines->stream = stream;
+}
+
+// Writes the pending points of the lines straight into their buffer
+static void _stream_write_direct(draw_lines* lines) {
+    u32 first = 0;
+    u32 buffer = 0;
+    u32 num_points = _lines_dirty_points(lines, &first, &buffer);
+
+    if (num_points == 0) {
+        return;
+    }
+
+    mga_temp scratch = mga_scratch_get(NULL, 0);
+
+    vec2f* points = MGA_PUSH_ARRAY(scratch.arena, vec2f, num_points);
+    _lines_take_dirty(lines, points);
+
+    glh_bind_buffer(GL_ARRAY_BUFFER, buffer);
+    glBufferSubData(GL_ARRAY_BUFFER, sizeof(vec2f) * first, sizeof(vec2f) * num_points, points);
+    glh_bind_buffer(GL_ARRAY_BUFFER, 0);
+
+    mga_scratch_release(scratch);
+}
+
+void draw_stream_remove(draw_stream* stream, draw_lines* lines) {
+    if (stream == NULL || lines == NULL) {
+        fprintf(stderr, "Cannot remove lines from stream: stream or lines is NULL\n");
+        return;
+    }
+    if (lines->stream != stream) {
+        fprintf(stderr, "Cannot remove lines from stream: lines are not in this stream\n");
+        return;
+    }
+
+    _stream_write_direct(lines);
+
+    for (u32 i = 0; i < stream->num_lines; i++) {
+        if (stream->lines[i] == lines) {
+            stream->lines[i] = stream->lines[--stream->num_lines];
+            break;
+        }
+    }
+
+    lines->stream = NULL;
+}
+
+// Waits until the GPU is done reading the current section, returns false if that takes too long
+static b32 _stream_wait_section(draw_stream* stream) {
+    GLsync fence = stream->fences[stream->section];
+
+    if (fence == NULL) {
+        return true;
+    }
+
+    u32 result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, STREAM_WAIT_TIMEOUT);
+
+    if (result == GL_TIMEOUT_EXPIRED || result == GL_WAIT_FAILED) {
+        return false;
+    }
+
+    glDeleteSync(fence);
+    stream->fences[stream->section] = NULL;
+
+    return true;
+}
+
+void draw_stream_flush(draw_stream* stream) {
+    if (stream == NULL) {
+        fprintf(stderr, "Cannot flush stream: stream is NULL\n");
+        return;
+    }
+
+    u32 total_points = 0;
+    for (u32 i = 0; i < stream->num_lines; i++) {
+        u32 first = 0;
+        u32 buffer = 0;
+        total_points += _lines_dirty_points(stream->lines[i], &first, &buffer);
+    }
+
+    if (total_points == 0) {
+        return;
+    }
+
+    if (stream->persistent && !_stream_wait_section(stream)) {
+        fprintf(stderr, "Cannot wait for stream section, writing points directly\n");
+
+        for (u32 i = 0; i < stream->num_lines; i++) {
+            _stream_write_direct(stream->lines[i]);
+        }
+
+        return;
+    }
+
+    mga_temp scratch = mga_scratch_get(NULL, 0);
+
+    u8* section = NULL;
+    if (stream->persistent) {
+        section = stream->mapped + (u64)STREAM_SECTION_SIZE * stream->section;
+    } else {
+        section = MGA_PUSH_ARRAY(scratch.arena, u8, MIN(sizeof(vec2f) * total_points, STREAM_SECTION_SIZE));
+    }
+
+    // Copies from the section into the point buffers
+    _stream_copy* copies = MGA_PUSH_ARRAY(scratch.arena, _stream_copy, stream->num_lines);
+    u32 num_copies = 0;
+    u32 section_size = 0;
+
+    for (u32 i = 0; i < stream->num_lines; i++) {
+        _stream_copy copy = { .offset = section_size };
+        copy.size = sizeof(vec2f) * _lines_dirty_points(stream->lines[i], &copy.first, &copy.buffer);
+
+        if (copy.size == 0) {
+            continue;
+        }
+
+        // Anything that does not fit gets written on its own
+        if (section_size + copy.size > STREAM_SECTION_SIZE) {
+            _stream_write_direct(stream->lines[i]);
+            continue;
+        }
+
+        _lines_take_dirty(stream->lines[i], (vec2f*)(section + section_size));
+
+        copies[num_copies++] = copy;
+        section_size += copy.size;
+    }
+
+    glh_bind_buffer(GL_COPY_READ_BUFFER, stream->buffer);
+
+    u32 read_offset = 0;
+
+    if (stream->persistent) {
+        read_offset = STREAM_SECTION_SIZE * stream->section;
+    } else {
+        // Respecifying the data orphans the storage the copies of the last flush read from
+        glBufferData(GL_COPY_READ_BUFFER, section_size, section, GL_STREAM_DRAW);
+    }
+
+    for (u32 i = 0; i < num_copies; i++) {
+        glh_bind_buffer(GL_COPY_WRITE_BUFFER, copies[i].buffer);
+        glCopyBufferSubData(
+            GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+            read_offset + copies[i].offset, sizeof(vec2f) * copies[i].first, copies[i].size
+        );
+    }
+
+    glh_bind_buffer(GL_COPY_READ_BUFFER, 0);
+    glh_bind_buffer(GL_COPY_WRITE_BUFFER, 0);
+
+    if (stream->persistent) {
+        stream->fences[stream->section] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        stream->section = (stream->section + 1) % STREAM_NUM_SECTIONS;
+    }
+
+    mga_scratch_release(scratch);
+}
+
+#endif // DRAW_BACKEND_OPENGL
@@ -0,0 +1,442 @@
+#include "draw/draw.h"
+
+#ifdef DRAW_BACKEND_OPENGL
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "gfx/opengl/opengl.h"
+#include "gfx/opengl/opengl_helpers.h"
+
+// Texels per side of a tile
+#define TILES_SIZE 256
+// Number of hash slots, must be a power of two
+#define TILES_NUM_SLOTS 1024
+// Texels around a tile that still invalidate it, the smoothed edges of lines reach past their bounding box
+#define TILES_PAD_PX 4.0f
+#define TILES_NONE 0xffffffffu
+
+// Defined in gl_impl_batch.c
+void _batch_split_lines(
+    const draw_batch* batch, draw_lines** lines, u32 num_lines, mg_arena* arena,
+    draw_lines*** batched, u32* num_batched, draw_lines*** others, u32* num_others
+);
+
+typedef struct {
+    i32 level;
+    i32 x, y;
+
+    // Next tile in the same hash slot
+    u32 next;
+
+    // Frame the tile was last drawn in, the least recently drawn tile gets reused first
+    u64 last_used;
+
+    b32 used;
+    b32 dirty;
+} _tile;
+
+typedef struct draw_tiles {
+    u32 max_tiles;
+    // Tile i is layer i of the texture
+    _tile* tiles;
+    u32* slots;
+
+    u64 frame;
+
+    u32 texture;
+    u32 framebuffer;
+
+    u32 program;
+    u32 view_mat_loc;
+    u32 tiles_loc;
+
+    u32 vertex_array;
+    u32 instance_buffer;
+    u32 instance_capacity;
+
+    draw_tiles_stats stats;
+} draw_tiles;
+
+typedef struct {
+    rectf rect;
+    f32 layer;
+} _tile_instance;
+
+static const char* tiles_vert;
+static const char* tiles_frag;
+
+draw_tiles* draw_tiles_create(mg_arena* arena, u32 max_tiles) {
+    draw_tiles* tiles = MGA_PUSH_ZERO_STRUCT(arena, draw_tiles);
+
+    tiles->max_tiles = max_tiles;
+    tiles->tiles = MGA_PUSH_ZERO_ARRAY(arena, _tile, max_tiles);
+    tiles->slots = MGA_PUSH_ARRAY(arena, u32, TILES_NUM_SLOTS);
+
+    memset(tiles->slots, 0xff, sizeof(u32) * TILES_NUM_SLOTS);
+
+    // Textures hold premultiplied colors, so that partly covered texels blend like the lines would
+    glGenTextures(1, &tiles->texture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, tiles->texture);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, TILES_SIZE, TILES_SIZE, max_tiles, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    glGenFramebuffers(1, &tiles->framebuffer);
+
+    tiles->program = glh_create_shader(tiles_vert, tiles_frag);
+
+    glh_use_program(tiles->program);
+    tiles->view_mat_loc = glGetUniformLocation(tiles->program, "u_view_mat");
+    tiles->tiles_loc = glGetUniformLocation(tiles->program, "u_tiles");
+    glh_use_program(0);
+
+    glGenVertexArrays(1, &tiles->vertex_array);
+    glh_bind_vertex_array(tiles->vertex_array);
+
+    glGenBuffers(1, &tiles->instance_buffer);
+    glh_bind_buffer(GL_ARRAY_BUFFER, tiles->instance_buffer);
+
+    glEnableVertexAttribArray(0);
+    glVertexAttribDivisor(0, 1);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(_tile_instance), (void*)offsetof(_tile_instance, rect));
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
+    glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, sizeof(_tile_instance), (void*)offsetof(_tile_instance, layer));
+
+    glh_bind_vertex_array(0);
+    glh_bind_buffer(GL_ARRAY_BUFFER, 0);
+
+    return tiles;
+}
+void draw_tiles_destroy(draw_tiles* tiles) {
+    if (tiles == NULL) {
+        fprintf(stderr, "Cannot destroy tiles: tiles is NULL\n");
+        return;
+    }
+
+    glDeleteTextures(1, &tiles->texture);
+    glDeleteFramebuffers(1, &tiles->framebuffer);
+    glh_delete_program(tiles->program);
+    glh_delete_vertex_arrays(1, &tiles->vertex_array);
+    glh_delete_buffers(1, &tiles->instance_buffer);
+}
+
+static u32 _tiles_hash(i32 level, i32 x, i32 y) {
+    return (((u32)x * 73856093u) ^ ((u32)y * 19349663u) ^ ((u32)level * 83492791u)) & (TILES_NUM_SLOTS - 1);
+}
+
+// World units per texel of a zoom level
+static f32 _tiles_texel_size(i32 level) {
+    return ldexpf(1.0f, level);
+}
+
+static rectf _tiles_rect(const _tile* tile) {
+    f32 size = TILES_SIZE * _tiles_texel_size(tile->level);
+
+    return (rectf){ tile->x * size, tile->y * size, size, size };
+}
+
+static u32 _tiles_find(const draw_tiles* tiles, i32 level, i32 x, i32 y) {
+    for (u32 i = tiles->slots[_tiles_hash(level, x, y)]; i != TILES_NONE; i = tiles->tiles[i].next) {
+        const _tile* tile = &tiles->tiles[i];
+
+        if (tile->level == level && tile->x == x && tile->y == y) {
+            return i;
+        }
+    }
+
+    return TILES_NONE;
+}
+
+static void _tiles_unlink(draw_tiles* tiles, u32 index) {
+    _tile* tile = &tiles->tiles[index];
+
+    for (u32* i = &tiles->slots[_tiles_hash(tile->level, tile->x, tile->y)]; *i != TILES_NONE; i = &tiles->tiles[*i].next) {
+        if (*i == index) {
+            *i = tile->next;
+            break;
+        }
+    }
+
+    tile->used = false;
+}
+
+// Takes an unused tile, or the least recently drawn one that was not drawn this frame
+static u32 _tiles_alloc(draw_tiles* tiles, i32 level, i32 x, i32 y) {
+    u32 index = TILES_NONE;
+
+    for (u32 i = 0; i < tiles->max_tiles; i++) {
+        const _tile* tile = &tiles->tiles[i];
+
+        if (!tile->used) {
+            index = i;
+            break;
+        }
+        if (tile->last_used < tiles->frame && (index == TILES_NONE || tile->last_used < tiles->tiles[index].last_used)) {
+            index = i;
+        }
+    }
+
+    if (index == TILES_NONE) {
+        return TILES_NONE;
+    }
+
+    if (tiles->tiles[index].used) {
+        _tiles_unlink(tiles, index);
+    }
+
+    u32* slot = &tiles->slots[_tiles_hash(level, x, y)];
+
+    tiles->tiles[index] = (_tile){
+        .level = level,
+        .x = x, .y = y,
+        .next = *slot,
+        .used = true,
+        .dirty = true,
+    };
+    *slot = index;
+
+    return index;
+}
+
+void draw_tiles_invalidate(draw_tiles* tiles, rectf rect) {
+    if (tiles == NULL) {
+        fprintf(stderr, "Cannot invalidate tiles: tiles is NULL\n");
+        return;
+    }
+
+    for (u32 i = 0; i < tiles->max_tiles; i++) {
+        _tile* tile = &tiles->tiles[i];
+
+        if (!tile->used || tile->dirty) {
+            continue;
+        }
+
+        f32 pad = TILES_PAD_PX * _tiles_texel_size(tile->level);
+        rectf padded = { rect.x - pad, rect.y - pad, rect.w + pad * 2.0f, rect.h + pad * 2.0f };
+
+        if (rectf_collide_rectf(_tiles_rect(tile), padded)) {
+            tile->dirty = true;
+        }
+    }
+}
+void draw_tiles_invalidate_all(draw_tiles* tiles) {
+    if (tiles == NULL) {
+        fprintf(stderr, "Cannot invalidate tiles: tiles is NULL\n");
+        return;
+    }
+
+    for (u32 i = 0; i < tiles->max_tiles; i++) {
+        tiles->tiles[i].dirty = true;
+    }
+}
+
+// Renders the batched lines into the layer of the tile, the framebuffer has to be bound already
+static void _tiles_render(
+    draw_tiles* tiles, u32 index, draw_batch* batch, draw_lines** lines, u32 num_lines,
+    const draw_lines_shaders* shaders
+) {
+    _tile* tile = &tiles->tiles[index];
+    rectf rect = _tiles_rect(tile);
+
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, tiles->texture, 0, index);
+
+    f32 clear_col[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    glClearBufferfv(GL_COLOR, 0, clear_col);
+
+    // World y points down, the same as in the view of the window
+    viewf tile_view = {
+        .center = { rect.x + rect.w * 0.5f, rect.y + rect.h * 0.5f },
+        .aspect_ratio = 1.0f,
+        .width = rect.w,
+        .rotation = 0.0f
+    };
+    gfx_window tile_win = { .width = TILES_SIZE, .height = TILES_SIZE };
+
+    draw_batch_draw(batch, lines, num_lines, shaders, &tile_win, tile_view);
+
+    tile->dirty = false;
+    tiles->stats.num_rendered++;
+}
+
+void draw_tiles_draw(
+    draw_tiles* tiles, draw_batch* batch, draw_lines** lines, u32 num_lines,
+    const draw_lines_shaders* shaders, const gfx_window* win, viewf view
+) {
+    if (tiles == NULL || batch == NULL) {
+        fprintf(stderr, "Cannot draw tiles: tiles or batch is NULL\n");
+        return;
+    }
+
+    tiles->stats = (draw_tiles_stats){ 0 };
+
+    if (win->width == 0 || win->height == 0) {
+        return;
+    }
+
+    tiles->frame++;
+
+    // Texels of the level are at most one screen pixel, and at least half of one
+    f32 pixel_size = view.width / (f32)win->width;
+    i32 level = (i32)floorf(log2f(pixel_size));
+    f32 tile_size = TILES_SIZE * _tiles_texel_size(level);
+
+    rectf bounds = viewf_bounds(view);
+
+    i32 min_x = (i32)floorf(bounds.x / tile_size);
+    i32 min_y = (i32)floorf(bounds.y / tile_size);
+    i32 max_x = (i32)floorf((bounds.x + bounds.w) / tile_size);
+    i32 max_y = (i32)floorf((bounds.y + bounds.h) / tile_size);
+
+    u64 num_tiles = (u64)(max_x - min_x + 1) * (u64)(max_y - min_y + 1);
+
+    if (num_tiles > tiles->max_tiles) {
+        draw_batch_draw(batch, lines, num_lines, shaders, win, view);
+        return;
+    }
+
+    mga_temp scratch = mga_scratch_get(NULL, 0);
+
+    // Lines outside the batch do not go into the tiles
+    draw_lines** batched = NULL;
+    u32 num_batched = 0;
+    draw_lines** overlay = NULL;
+    u32 num_overlay = 0;
+    _batch_split_lines(batch, lines, num_lines, scratch.arena, &batched, &num_batched, &overlay, &num_overlay);
+
+    _tile_instance* instances = MGA_PUSH_ARRAY(scratch.arena, _tile_instance, num_tiles);
+    u32 num_instances = 0;
+
+    // Only changed when a tile has to be rendered
+    i32 prev_framebuffer = -1;
+    i32 prev_viewport[4] = { 0 };
+    // The scissor rect of the screen would cut the tiles
+    b32 prev_scissor = false;
+
+    for (i32 y = min_y; y <= max_y; y++) {
+        for (i32 x = min_x; x <= max_x; x++) {
+            u32 index = _tiles_find(tiles, level, x, y);
+
+            if (index == TILES_NONE) {
+                index = _tiles_alloc(tiles, level, x, y);
+            }
+
+            _tile* tile = &tiles->tiles[index];
+            tile->last_used = tiles->frame;
+
+            if (tile->dirty) {
+                if (prev_framebuffer < 0) {
+                    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &prev_framebuffer);
+                    glGetIntegerv(GL_VIEWPORT, prev_viewport);
+                    prev_scissor = glIsEnabled(GL_SCISSOR_TEST);
+
+                    glDisable(GL_SCISSOR_TEST);
+                    glBindFramebuffer(GL_FRAMEBUFFER, tiles->framebuffer);
+                    glViewport(0, 0, TILES_SIZE, TILES_SIZE);
+                    glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+                }
+
+                _tiles_render(tiles, index, batch, batched, num_batched, shaders);
+            }
+
+            instances[num_instances++] = (_tile_instance){ _tiles_rect(tile), (f32)index };
+        }
+    }
+
+    if (prev_framebuffer >= 0) {
+        glBindFramebuffer(GL_FRAMEBUFFER, prev_framebuffer);
+        glViewport(prev_viewport[0], prev_viewport[1], prev_viewport[2], prev_viewport[3]);
+
+        if (prev_scissor) {
+            glEnable(GL_SCISSOR_TEST);
+        }
+    }
+
+    tiles->stats.num_drawn = num_instances;
+
+    mat3f view_mat = { 0 };
+    mat3f_from_view(&view_mat, view);
+
+    glh_bind_buffer(GL_ARRAY_BUFFER, tiles->instance_buffer);
+    if (num_instances > tiles->instance_capacity) {
+        tiles->instance_capacity = tiles->max_tiles;
+        glBufferData(GL_ARRAY_BUFFER, sizeof(_tile_instance) * tiles->instance_capacity, NULL, GL_STREAM_DRAW);
+    }
+    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(_tile_instance) * num_instances, instances);
+    glh_bind_buffer(GL_ARRAY_BUFFER, 0);
+
+    glh_use_program(tiles->program);
+    glUniformMatrix3fv(tiles->view_mat_loc, 1, GL_FALSE, view_mat.m);
+    glUniform1i(tiles->tiles_loc, 0);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, tiles->texture);
+
+    glh_bind_vertex_array(tiles->vertex_array);
+
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, num_instances);
+    // Back to the blending everything else is drawn with
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    glh_bind_vertex_array(0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    glh_use_program(0);
+
+    for (u32 i = 0; i < num_overlay; i++) {
+        if (rectf_collide_rectf(overlay[i]->bounding_box, bounds)) {
+            draw_lines_draw(overlay[i], shaders, win, view);
+        }
+    }
+
+    mga_scratch_release(scratch);
+}
+
+draw_tiles_stats draw_tiles_get_stats(const draw_tiles* tiles) {
+    return tiles->stats;
+}
+
+static const char* tiles_vert = GLSL_SOURCE(
+    330,
+
+    layout (location = 0) in vec4 a_rect;
+    layout (location = 1) in float a_layer;
+
+    out vec3 uv;
+
+    uniform mat3 u_view_mat;
+
+    void main() {
+        // Corners of the quad in strip order
+        vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1));
+        vec2 pos = a_rect.xy + corner * a_rect.zw;
+
+        // Tiles were rendered with world y pointing down, so the texture is upside down
+        uv = vec3(corner.x, 1.0 - corner.y, a_layer);
+
+        gl_Position = vec4((u_view_mat * vec3(pos, 1.0)).xy, 0.0, 1.0);
+    }
+);
+
+static const char* tiles_frag = GLSL_SOURCE(
+    330,
+
+    precision mediump sampler2DArray;
+
+    in vec3 uv;
+
+    layout (location = 0) out vec4 out_col;
+
+    uniform sampler2DArray u_tiles;
+
+    void main() {
+        out_col = texture(u_tiles, uv);
+    }
+);
+
+#endif // DRAW_BACKEND_OPENGL
@@ -11,6 +11,8 @@ typedef struct {
     u32 width, height;
 
     b32 should_close;
+    // Set when parts of the window have to be drawn again, even though nothing in it changed
+    b32 exposed;
 
     vec2f mouse_pos;
     i32 mouse_scroll;
@@ -26,12 +28,19 @@ typedef struct {
 gfx_window* gfx_win_create(mg_arena* arena, u32 width, u32 height, string8 title);
 void gfx_win_destroy(gfx_window* win);
 
-void gfx_win_process_events(gfx_window* win);
+// Waits up to timeout_ms for an event if none are pending, 0 returns right away
+void gfx_win_process_events(gfx_window* win, u32 timeout_ms);
 
 void gfx_win_make_current(gfx_window* win);
 void gfx_win_clear(gfx_window* win);
 void gfx_win_swap_buffers(gfx_window* win);
 
+// Frames since the back buffer was drawn, 1 if it still shows the last frame.
+// 0 if its contents are unknown and everything has to be drawn again
+u32 gfx_win_buffer_age(gfx_window* win);
+// Like gfx_win_swap_buffers, where only rect (in pixels from the top left) changed since the last frame
+void gfx_win_swap_buffers_damage(gfx_window* win, rectf rect);
+
 #define GFX_IS_MOUSE_DOWN(win, mb) ( win->mouse_buttons[mb])
 #define GFX_IS_MOUSE_UP(win, mb)   (!win->mouse_buttons[mb])
 #define GFX_IS_MOUSE_JUST_DOWN(win, mb) (win->mouse_buttons[mb] && !win->prev_mouse_buttons[mb])
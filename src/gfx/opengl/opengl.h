@@ -691,6 +691,14 @@ typedef struct __GLsync *GLsync;
 #define GL_NUM_SAMPLE_COUNTS              0x9380
 #define GL_TEXTURE_IMMUTABLE_LEVELS       0x82DF
 #define GL_SHADER_STORAGE_BUFFER          0x90D2
+#define GL_COMPUTE_SHADER                 0x91B9
+#define GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT 0x00000001
+#define GL_ELEMENT_ARRAY_BARRIER_BIT      0x00000002
+#define GL_BUFFER_UPDATE_BARRIER_BIT      0x00000200
+#define GL_MAP_PERSISTENT_BIT             0x0040
+#define GL_DRAW_INDIRECT_BUFFER           0x8F3F
+#define GL_COMMAND_BARRIER_BIT            0x00000040
+#define GL_MAP_COHERENT_BIT               0x0080
 
 #endif // __EMSCRIPTEN__
 
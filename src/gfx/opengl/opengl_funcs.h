@@ -206,4 +206,9 @@ X(void, glTexStorage2D, (GLenum target, GLsizei levels, GLenum internalformat, G
 X(void, glTexStorage3D, (GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height, GLsizei depth))
 X(void, glGetInternalformativ, (GLenum target, GLenum internalformat, GLenum pname, GLsizei bufSize, GLint *params))
 X(void, glGetBufferSubData, (GLenum target, GLintptr offset, GLsizeiptr size, void * data))
+X(void, glDispatchCompute, (GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z))
+X(void, glMemoryBarrier, (GLbitfield barriers))
+X(void, glBufferStorage, (GLenum target, GLsizeiptr size, const void *data, GLbitfield flags))
+X(void, glMultiDrawArrays, (GLenum mode, const GLint *first, const GLsizei *count, GLsizei drawcount))
+X(void, glMultiDrawArraysIndirect, (GLenum mode, const void *indirect, GLsizei drawcount, GLsizei stride))
 
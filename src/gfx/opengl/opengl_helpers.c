@@ -12,6 +12,7 @@
 #include "opengl.h"
 
 #include <stdio.h>
+#include <string.h>
 
 u32 glh_create_shader(const char* vertex_source, const char* fragment_source) {
     u32 vertex_shader;
@@ -62,8 +63,212 @@ u32 glh_create_buffer(u32 buffer_type, u64 size, void* data, u32 draw_type) {
     u32 buffer = 0;
 
     glGenBuffers(1, &buffer);
-    glBindBuffer(buffer_type, buffer);
+    glh_bind_buffer(buffer_type, buffer);
     glBufferData(buffer_type, size, data, draw_type);
 
     return buffer;
 }
+
+// Marks a binding that GL might not have
+#define GLH_UNKNOWN 0xffffffff
+// Uniforms past this many are uploaded every time
+#define GLH_MAX_UNIFORMS 64
+
+typedef struct {
+    u32 program;
+    i32 loc;
+    u32 size;
+    // Compared as bytes, so ints and floats share the slot
+    u32 values[9];
+} _glh_uniform;
+
+static struct {
+    u32 program;
+    u32 vertex_array;
+    u32 array_buffer;
+
+    _glh_uniform uniforms[GLH_MAX_UNIFORMS];
+    u32 num_uniforms;
+
+    glh_state_stats stats;
+} _glh_state = { .program = GLH_UNKNOWN, .vertex_array = GLH_UNKNOWN, .array_buffer = GLH_UNKNOWN };
+
+// Returns true if the GL call has to be made
+static b32 _glh_bind_needed(u32* bound, u32 object) {
+    if (*bound == object) {
+        _glh_state.stats.num_skipped_binds++;
+        return false;
+    }
+
+    *bound = object;
+    _glh_state.stats.num_binds++;
+
+    return true;
+}
+
+void glh_use_program(u32 program) {
+    if (_glh_bind_needed(&_glh_state.program, program)) {
+        glUseProgram(program);
+    }
+}
+void glh_bind_vertex_array(u32 vertex_array) {
+    if (_glh_bind_needed(&_glh_state.vertex_array, vertex_array)) {
+        glBindVertexArray(vertex_array);
+    }
+}
+void glh_bind_buffer(u32 target, u32 buffer) {
+    if (target != GL_ARRAY_BUFFER) {
+        _glh_state.stats.num_binds++;
+        glBindBuffer(target, buffer);
+    } else if (_glh_bind_needed(&_glh_state.array_buffer, buffer)) {
+        glBindBuffer(target, buffer);
+    }
+}
+
+static void _glh_forget_uniforms(u32 program) {
+    for (u32 i = 0; i < _glh_state.num_uniforms;) {
+        if (_glh_state.uniforms[i].program == program) {
+            _glh_state.uniforms[i] = _glh_state.uniforms[--_glh_state.num_uniforms];
+        } else {
+            i++;
+        }
+    }
+}
+
+void glh_delete_program(u32 program) {
+    if (_glh_state.program == program) {
+        _glh_state.program = GLH_UNKNOWN;
+    }
+    _glh_forget_uniforms(program);
+
+    glDeleteProgram(program);
+}
+void glh_delete_vertex_arrays(i32 n, const u32* vertex_arrays) {
+    for (i32 i = 0; i < n; i++) {
+        if (_glh_state.vertex_array == vertex_arrays[i]) {
+            _glh_state.vertex_array = GLH_UNKNOWN;
+        }
+    }
+
+    glDeleteVertexArrays(n, vertex_arrays);
+}
+void glh_delete_buffers(i32 n, const u32* buffers) {
+    for (i32 i = 0; i < n; i++) {
+        if (_glh_state.array_buffer == buffers[i]) {
+            _glh_state.array_buffer = GLH_UNKNOWN;
+        }
+    }
+
+    glDeleteBuffers(n, buffers);
+}
+
+// Returns true if the uniform of the current program has to be uploaded, and remembers the values
+static b32 _glh_uniform_needed(i32 loc, const void* values, u32 size) {
+    if (_glh_state.program == GLH_UNKNOWN || loc < 0) {
+        _glh_state.stats.num_uniforms++;
+        return true;
+    }
+
+    _glh_uniform* uniform = NULL;
+    for (u32 i = 0; i < _glh_state.num_uniforms; i++) {
+        if (_glh_state.uniforms[i].program == _glh_state.program && _glh_state.uniforms[i].loc == loc) {
+            uniform = &_glh_state.uniforms[i];
+            break;
+        }
+    }
+
+    if (uniform != NULL && uniform->size == size && memcmp(uniform->values, values, sizeof(u32) * size) == 0) {
+        _glh_state.stats.num_skipped_uniforms++;
+        return false;
+    }
+
+    if (uniform == NULL && _glh_state.num_uniforms < GLH_MAX_UNIFORMS) {
+        uniform = &_glh_state.uniforms[_glh_state.num_uniforms++];
+        uniform->program = _glh_state.program;
+        uniform->loc = loc;
+    }
+    if (uniform != NULL) {
+        uniform->size = size;
+        memcpy(uniform->values, values, sizeof(u32) * size);
+    }
+
+    _glh_state.stats.num_uniforms++;
+
+    return true;
+}
+
+void glh_uniform_1i(i32 loc, i32 v) {
+    if (_glh_uniform_needed(loc, &v, 1)) {
+        glUniform1i(loc, v);
+    }
+}
+void glh_uniform_1f(i32 loc, f32 v) {
+    if (_glh_uniform_needed(loc, &v, 1)) {
+        glUniform1f(loc, v);
+    }
+}
+void glh_uniform_2f(i32 loc, f32 x, f32 y) {
+    f32 v[2] = { x, y };
+    if (_glh_uniform_needed(loc, v, 2)) {
+        glUniform2f(loc, x, y);
+    }
+}
+void glh_uniform_4f(i32 loc, f32 x, f32 y, f32 z, f32 w) {
+    f32 v[4] = { x, y, z, w };
+    if (_glh_uniform_needed(loc, v, 4)) {
+        glUniform4f(loc, x, y, z, w);
+    }
+}
+void glh_uniform_mat3f(i32 loc, const f32* m) {
+    if (_glh_uniform_needed(loc, m, 9)) {
+        glUniformMatrix3fv(loc, 1, GL_FALSE, m);
+    }
+}
+
+void glh_state_reset(void) {
+    _glh_state.program = GLH_UNKNOWN;
+    _glh_state.vertex_array = GLH_UNKNOWN;
+    _glh_state.array_buffer = GLH_UNKNOWN;
+    _glh_state.num_uniforms = 0;
+}
+void glh_state_new_frame(void) {
+    _glh_state.stats = (glh_state_stats){ 0 };
+}
+glh_state_stats glh_state_get_stats(void) {
+    return _glh_state.stats;
+}
+
+#ifndef PLATFORM_WASM
+
+u32 glh_create_compute_shader(const char* compute_source) {
+    u32 compute_shader;
+    compute_shader = glCreateShader(GL_COMPUTE_SHADER);
+    glShaderSource(compute_shader, 1, &compute_source, NULL);
+    glCompileShader(compute_shader);
+
+    i32 success = GL_TRUE;
+    glGetShaderiv(compute_shader, GL_COMPILE_STATUS, &success);
+    if(success == GL_FALSE) {
+        char info_log[512];
+        glGetShaderInfoLog(compute_shader, 512, NULL, info_log);
+        fprintf(stderr, "Failed to compile compute shader: %s\n", info_log);
+    }
+
+    u32 shader_program;
+    shader_program = glCreateProgram();
+    glAttachShader(shader_program, compute_shader);
+    glLinkProgram(shader_program);
+
+    glGetProgramiv(shader_program, GL_LINK_STATUS, &success);
+    if(!success) {
+        char info_log[512];
+        glGetProgramInfoLog(shader_program, 512, NULL, info_log);
+        fprintf(stderr, "Failed to link shader: %s\n", info_log);
+    }
+
+    glDeleteShader(compute_shader);
+
+    return shader_program;
+}
+
+#endif
@@ -6,4 +6,42 @@
 u32 glh_create_shader(const char* vertex_source, const char* fragment_source);
 u32 glh_create_buffer(u32 buffer_type, u64 size, void* data, u32 draw_type);
 
+typedef struct {
+    // Calls since the last glh_state_new_frame that reached GL,
+    // and calls that were dropped because GL already had that state
+    u32 num_binds;
+    u32 num_skipped_binds;
+    u32 num_uniforms;
+    u32 num_skipped_uniforms;
+} glh_state_stats;
+
+// Shadows the current program, vertex array and array buffer, and the uniforms set with glh_uniform_*,
+// so setting them to what they already are costs no GL call. Bindings stay until the next bind,
+// so code that binds these directly has to call glh_state_reset. Assumes a single context
+void glh_use_program(u32 program);
+void glh_bind_vertex_array(u32 vertex_array);
+// Targets other than GL_ARRAY_BUFFER are bound every time
+void glh_bind_buffer(u32 target, u32 buffer);
+
+// Deleted names can come back from glGen*, so they are forgotten
+void glh_delete_program(u32 program);
+void glh_delete_vertex_arrays(i32 n, const u32* vertex_arrays);
+void glh_delete_buffers(i32 n, const u32* buffers);
+
+// Set uniforms of the current program. All uniforms of a program have to be set through these
+void glh_uniform_1i(i32 loc, i32 v);
+void glh_uniform_1f(i32 loc, f32 v);
+void glh_uniform_2f(i32 loc, f32 x, f32 y);
+void glh_uniform_4f(i32 loc, f32 x, f32 y, f32 z, f32 w);
+void glh_uniform_mat3f(i32 loc, const f32* m);
+
+void glh_state_reset(void);
+void glh_state_new_frame(void);
+glh_state_stats glh_state_get_stats(void);
+
+#ifndef PLATFORM_WASM
+// Needs a GL 4.3 context
+u32 glh_create_compute_shader(const char* compute_source);
+#endif
+
 #endif // OPENGL_HELPERS_H
@@ -7,6 +7,8 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <math.h>
+#include <poll.h>
 
 #include <X11/Xlib.h>
 #include <X11/Xutil.h>
@@ -14,6 +16,8 @@
 #include <GL/glx.h>
 #include <GL/gl.h>
 
+typedef void (*glXCopySubBufferMESAProc) (Display*, GLXDrawable, int, int, int, int);
+
 typedef struct _gfx_win_backend {
     Display* display;
     i32 screen;
@@ -21,10 +25,21 @@ typedef struct _gfx_win_backend {
     Window window;
     GLXContext gl_context;
     Atom del_atom;
+
+    // GLX_EXT_buffer_age
+    b32 has_buffer_age;
+    // GLX_MESA_copy_sub_buffer, used to present the changed rect when the buffer age is unknown.
+    // The back buffer keeps its contents, as long as nothing but the copies presents it
+    glXCopySubBufferMESAProc copy_sub_buffer;
+    b32 back_buffer_kept;
 } _gfx_win_backend;
 
 typedef GLXContext (*glXCreateContextAttribsARBProc) (Display*, GLXFBConfig, GLXContext, Bool, const int*);
 
+#ifndef GLX_BACK_BUFFER_AGE_EXT
+#define GLX_BACK_BUFFER_AGE_EXT 0x20F4
+#endif
+
 #define X(ret, name, args) gl_##name##_func name = NULL;
 #   include "opengl_funcs.h"
 #undef X
@@ -162,6 +177,15 @@ gfx_window* gfx_win_create(mg_arena* arena, u32 width, u32 height, string8 title
     
     glViewport(0, 0, width, height);
 
+    const char* glx_extensions = glXQueryExtensionsString(win->backend->display, win->backend->screen);
+    if (glx_extensions != NULL) {
+        win->backend->has_buffer_age = strstr(glx_extensions, "GLX_EXT_buffer_age") != NULL;
+
+        if (strstr(glx_extensions, "GLX_MESA_copy_sub_buffer") != NULL) {
+            win->backend->copy_sub_buffer = (glXCopySubBufferMESAProc)glXGetProcAddress((const GLubyte*)"glXCopySubBufferMESA");
+        }
+    }
+
     #define X(ret, name, args) name = (gl_##name##_func)glXGetProcAddress((const GLubyte*)#name);
     #    include "opengl_funcs.h"
     #undef X
@@ -181,10 +205,21 @@ void gfx_win_destroy(gfx_window* win) {
     XCloseDisplay(win->backend->display);
 }
 
-void gfx_win_process_events(gfx_window* win) {
+void gfx_win_process_events(gfx_window* win, u32 timeout_ms) {
     memcpy(win->prev_mouse_buttons, win->mouse_buttons, GFX_NUM_MOUSE_BUTTONS);
     memcpy(win->prev_keys, win->keys, GFX_NUM_KEYS);
     win->mouse_scroll = 0;
+    win->exposed = false;
+
+    // XPending also flushes the requests, so nothing gets stuck while waiting
+    if (timeout_ms > 0 && XPending(win->backend->display) == 0) {
+        struct pollfd display_fd = {
+            .fd = ConnectionNumber(win->backend->display),
+            .events = POLLIN
+        };
+
+        poll(&display_fd, 1, (int)timeout_ms);
+    }
     
     while (XPending(win->backend->display)) {
         XEvent e = { 0 };
@@ -195,6 +230,10 @@ void gfx_win_process_events(gfx_window* win) {
                 glViewport(0, 0, e.xexpose.width, e.xexpose.height);
                 win->width = e.xexpose.width;
                 win->height = e.xexpose.height;
+
+                // Resized or uncovered, the copies of the changed rects are not enough anymore
+                win->backend->back_buffer_kept = false;
+                win->exposed = true;
             } break;
             case ButtonPress: {
                 if (e.xbutton.button == 4) {
@@ -242,6 +281,36 @@ void gfx_win_clear(gfx_window* win) {
 }
 void gfx_win_swap_buffers(gfx_window* win) {
     glXSwapBuffers(win->backend->display, win->backend->window);
+
+    win->backend->back_buffer_kept = false;
+}
+u32 gfx_win_buffer_age(gfx_window* win) {
+    if (win->backend->has_buffer_age) {
+        u32 age = 0;
+        glXQueryDrawable(win->backend->display, win->backend->window, GLX_BACK_BUFFER_AGE_EXT, &age);
+
+        return age;
+    }
+
+    return win->backend->back_buffer_kept ? 1 : 0;
+}
+void gfx_win_swap_buffers_damage(gfx_window* win, rectf rect) {
+    if (win->backend->has_buffer_age || win->backend->copy_sub_buffer == NULL) {
+        gfx_win_swap_buffers(win);
+        return;
+    }
+
+    i32 x0 = CLAMP((i32)floorf(rect.x), 0, (i32)win->width);
+    i32 y0 = CLAMP((i32)floorf(rect.y), 0, (i32)win->height);
+    i32 x1 = CLAMP((i32)ceilf(rect.x + rect.w), 0, (i32)win->width);
+    i32 y1 = CLAMP((i32)ceilf(rect.y + rect.h), 0, (i32)win->height);
+
+    // GLX rows start at the bottom
+    win->backend->copy_sub_buffer(
+        win->backend->display, win->backend->window, x0, (i32)win->height - y1, x1 - x0, y1 - y0
+    );
+
+    win->backend->back_buffer_kept = true;
 }
 
 // Adapted from sokol_app.h
@@ -14,6 +14,8 @@
 typedef struct _gfx_win_backend {
     EMSCRIPTEN_WEBGL_CONTEXT_HANDLE ctx;
     b32 new_scroll;
+    // Set by the callbacks, which only run while the program sleeps
+    b32 new_event;
 } _gfx_win_backend;
 
 static EM_BOOL on_mouse_event(int event_type, const EmscriptenMouseEvent* e, void* win_ptr);
@@ -25,6 +27,9 @@ static EM_BOOL on_ui_event(int event_type, const EmscriptenUiEvent *e, void *win
 
 #define CANVAS_ID "wasm_canvas"
 
+// Longest sleep while waiting for events, the callbacks cannot wake the program up
+#define WASM_WAIT_STEP_MS 4
+
 gfx_window* gfx_win_create(mg_arena* arena, u32 width, u32 height, string8 title) {
     UNUSED(title);
 
@@ -83,7 +88,17 @@ void gfx_win_swap_buffers(gfx_window* win) {
     
     emscripten_webgl_commit_frame();
 }
-void gfx_win_process_events(gfx_window* win) {
+u32 gfx_win_buffer_age(gfx_window* win) {
+    UNUSED(win);
+
+    return 0;
+}
+void gfx_win_swap_buffers_damage(gfx_window* win, rectf rect) {
+    UNUSED(rect);
+
+    gfx_win_swap_buffers(win);
+}
+void gfx_win_process_events(gfx_window* win, u32 timeout_ms) {
     memcpy(win->prev_mouse_buttons, win->mouse_buttons, GFX_NUM_MOUSE_BUTTONS);
     memcpy(win->prev_keys, win->keys, GFX_NUM_KEYS);
 
@@ -91,6 +106,14 @@ void gfx_win_process_events(gfx_window* win) {
         win->mouse_scroll = 0;
     }
     win->backend->new_scroll = 0;
+
+    // Always gives the browser a chance to run the callbacks, then sleeps in short steps until one of them ran
+    win->backend->new_event = false;
+    f64 end = emscripten_get_now() + timeout_ms;
+    do {
+        f64 remaining = end - emscripten_get_now();
+        emscripten_sleep((u32)CLAMP(remaining, 0.0, (f64)WASM_WAIT_STEP_MS));
+    } while (!win->backend->new_event && emscripten_get_now() < end);
 }
 
 void gfx_win_set_size(gfx_window* win, u32 width, u32 height) {
@@ -103,6 +126,7 @@ void gfx_win_set_size(gfx_window* win, u32 width, u32 height) {
 
 static EM_BOOL on_mouse_event(int event_type, const EmscriptenMouseEvent* e, void* win_ptr) {
     gfx_window* win = (gfx_window*)win_ptr;
+    win->backend->new_event = true;
 
     switch (event_type) { 
         case EMSCRIPTEN_EVENT_MOUSEDOWN: {
@@ -128,12 +152,14 @@ static EM_BOOL on_wheel_event(int event_type, const EmscriptenWheelEvent* e, voi
 
     win->mouse_scroll = -SIGN(e->deltaY);
     win->backend->new_scroll = true;
+    win->backend->new_event = true;
 
     return true;
 }
 
 static EM_BOOL on_touch_event(int event_type, const EmscriptenTouchEvent* e, void* win_ptr) {
     gfx_window* win = (gfx_window*)win_ptr;
+    win->backend->new_event = true;
 
     switch (event_type) {
         case EMSCRIPTEN_EVENT_TOUCHSTART: {
@@ -157,6 +183,7 @@ static gfx_key em_translate_keycode(const char* code_str);
 
 static EM_BOOL on_key_event(int event_type, const EmscriptenKeyboardEvent* e, void* win_ptr) {
     gfx_window* win = (gfx_window*)win_ptr;
+    win->backend->new_event = true;
 
     switch(event_type) {
         case EMSCRIPTEN_EVENT_KEYDOWN: {
@@ -174,6 +201,7 @@ static EM_BOOL on_key_event(int event_type, const EmscriptenKeyboardEvent* e, vo
 
 static EM_BOOL on_ui_event(int event_type, const EmscriptenUiEvent *e, void *win_ptr) {
     gfx_window* win = (gfx_window*)win_ptr;
+    win->backend->new_event = true;
 
     switch (event_type) {
         case EMSCRIPTEN_EVENT_RESIZE: {
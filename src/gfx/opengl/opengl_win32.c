@@ -213,12 +213,17 @@ void gfx_win_destroy(gfx_window* win) {
     DestroyWindow(win->backend->window);
 }
 
-void gfx_win_process_events(gfx_window* win) {
+void gfx_win_process_events(gfx_window* win, u32 timeout_ms) {
     memcpy(win->prev_mouse_buttons, win->mouse_buttons, GFX_NUM_MOUSE_BUTTONS);
     memcpy(win->prev_keys, win->keys, GFX_NUM_KEYS);
     win->mouse_scroll = 0;
+    win->exposed = false;
 
     MSG msg = { 0 };
+    if (timeout_ms > 0 && !PeekMessageW(&msg, NULL, 0, 0, PM_NOREMOVE)) {
+        MsgWaitForMultipleObjects(0, NULL, FALSE, timeout_ms, QS_ALLINPUT);
+    }
+
     while (PeekMessageW(&msg, NULL, 0, 0, PM_REMOVE)) {
         TranslateMessage(&msg);
         DispatchMessageW(&msg);
@@ -236,6 +241,17 @@ void gfx_win_clear(gfx_window* win) {
 void gfx_win_swap_buffers(gfx_window* win) {
     SwapBuffers(win->backend->device_context);
 }
+u32 gfx_win_buffer_age(gfx_window* win) {
+    UNUSED(win);
+
+    // The back buffer is undefined after SwapBuffers
+    return 0;
+}
+void gfx_win_swap_buffers_damage(gfx_window* win, rectf rect) {
+    UNUSED(rect);
+
+    SwapBuffers(win->backend->device_context);
+}
 
 static LRESULT CALLBACK w32_window_proc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
     gfx_window* win = GetPropW(hWnd, L"gfx_win");
@@ -288,6 +304,13 @@ static LRESULT CALLBACK w32_window_proc(HWND hWnd, UINT uMsg, WPARAM wParam, LPA
             glViewport(0, 0, width, height);
         } break;
 
+        case WM_PAINT: {
+            // Uncovered or resized. Validating the window stops Windows from sending WM_PAINT again
+            win->exposed = true;
+            ValidateRect(hWnd, NULL);
+            return 0;
+        }
+
         case WM_CLOSE: {
             win->should_close = true;
         } break;
@@ -17,6 +17,23 @@
 
 #define INTERP_MARGIN 0.01f
 
+#define MAX_LINES 65536
+#define MAX_UNDO 65536
+// Tiles of 256x256 texels kept on the GPU, 64 MiB
+#define MAX_TILES 256
+// Frames of damage kept for back buffers older than the last frame
+#define MAX_DAMAGE_AGE 4
+// Pixels drawn again around a change, for the smoothed edges
+#define DAMAGE_PAD_PX 2.0f
+// Longest wait for events while nothing moves, in milliseconds
+#define IDLE_WAIT_MS 250
+// Longest time step, so that a slow frame does not jump
+#define MAX_FRAME_DELTA (1.0f / 30.0f)
+// Every scroll notch zooms as far as it did in one 60 Hz frame, whatever the frame time is
+#define ZOOM_NOTCH_TIME (1.0f / 60.0f)
+// The smooth zoom stops this close to its target, relative to the view width
+#define ZOOM_SNAP 1e-4f
+
 typedef struct
 {
     f32 zoom_speed;
@@ -24,6 +41,16 @@ typedef struct
     f32 default_color_r;
     f32 default_color_g;
     f32 default_color_b;
+    // Finished strokes are simplified to this many screen pixels, 0 turns it off
+    f32 simplify_tolerance;
+    // Finished strokes are drawn from cached textures
+    b32 tile_cache;
+    // Documents smaller than this many screen pixels are drawn from one mipmapped texture, 0 turns it off
+    f32 overview_screen_size;
+    // Without the tile cache, pans and zooms move the last frame and only draw what it does not cover
+    b32 reproject;
+    // While the view stays the same, only the parts of the window that changed get drawn again
+    b32 partial_redraw;
 } app_config;
 
 typedef enum
@@ -37,11 +64,27 @@ typedef struct
     undo_action_type type;
     u32 line_idx;
     draw_lines *backup;
+    // What was left of the erased lines
+    draw_lines **pieces;
+    u32 num_pieces;
 } undo_action;
 
+// What changed since the last frame
+typedef struct
+{
+    // Everything gets drawn again
+    b32 full;
+    // Lines, in world units
+    b32 has_world;
+    rectf world;
+    // UI, in window pixels from the top left
+    b32 has_screen;
+    rectf screen;
+} frame_damage;
+
 app_config load_config(const char *filename)
 {
-    app_config config = {10.0f, 5.0f, 1.0f, 1.0f, 1.0f}; // Defaults
+    app_config config = {10.0f, 5.0f, 1.0f, 1.0f, 1.0f, 0.5f, true, 512.0f, true, true}; // Defaults
     FILE *f = fopen(filename, "r");
     if (f)
     {
@@ -62,6 +105,16 @@ app_config load_config(const char *filename)
                     config.default_color_g = val;
                 else if (strcmp(key, "default_color_b") == 0)
                     config.default_color_b = val;
+                else if (strcmp(key, "simplify_tolerance") == 0)
+                    config.simplify_tolerance = val;
+                else if (strcmp(key, "tile_cache") == 0)
+                    config.tile_cache = val != 0.0f;
+                else if (strcmp(key, "overview_screen_size") == 0)
+                    config.overview_screen_size = val;
+                else if (strcmp(key, "reproject") == 0)
+                    config.reproject = val != 0.0f;
+                else if (strcmp(key, "partial_redraw") == 0)
+                    config.partial_redraw = val != 0.0f;
             }
         }
         fclose(f);
@@ -69,6 +122,90 @@ app_config load_config(const char *filename)
     return config;
 }
 
+void damage_add_world(frame_damage *damage, rectf rect)
+{
+    damage->world = damage->has_world ? rectf_union(damage->world, rect) : rect;
+    damage->has_world = true;
+}
+
+void damage_add_screen(frame_damage *damage, rectf rect)
+{
+    damage->screen = damage->has_screen ? rectf_union(damage->screen, rect) : rect;
+    damage->has_screen = true;
+}
+
+// Union where rects without area count as empty
+rectf damage_union(rectf a, rectf b)
+{
+    if (a.w <= 0.0f || a.h <= 0.0f)
+        return b;
+    if (b.w <= 0.0f || b.h <= 0.0f)
+        return a;
+    return rectf_union(a, b);
+}
+
+// Whole window pixels covering the damage, with the lines seen through view_mat. Without area if nothing changed
+rectf damage_screen_rect(const frame_damage *damage, const mat3f *view_mat, u32 width, u32 height)
+{
+    if (damage->full)
+        return (rectf){0.0f, 0.0f, (f32)width, (f32)height};
+
+    rectf rect = {0};
+
+    if (damage->has_world)
+    {
+        rectf w = damage->world;
+        // The view can be rotated, so all corners count
+        vec2f corners[4] = {
+            {w.x, w.y},
+            {w.x + w.w, w.y},
+            {w.x, w.y + w.h},
+            {w.x + w.w, w.y + w.h}};
+
+        f32 min_x = INFINITY, min_y = INFINITY;
+        f32 max_x = -INFINITY, max_y = -INFINITY;
+        for (u32 i = 0; i < 4; i++)
+        {
+            vec2f p = mat3f_mul_vec2f(view_mat, corners[i]);
+            f32 x = (p.x + 1.0f) * 0.5f * width;
+            f32 y = (1.0f - p.y) * 0.5f * height;
+
+            min_x = MIN(min_x, x);
+            min_y = MIN(min_y, y);
+            max_x = MAX(max_x, x);
+            max_y = MAX(max_y, y);
+        }
+
+        rect = (rectf){min_x, min_y, max_x - min_x, max_y - min_y};
+    }
+    if (damage->has_screen)
+        rect = damage->has_world ? rectf_union(rect, damage->screen) : damage->screen;
+    if (!damage->has_world && !damage->has_screen)
+        return (rectf){0};
+
+    f32 x0 = MAX(floorf(rect.x) - DAMAGE_PAD_PX, 0.0f);
+    f32 y0 = MAX(floorf(rect.y) - DAMAGE_PAD_PX, 0.0f);
+    f32 x1 = MIN(ceilf(rect.x + rect.w) + DAMAGE_PAD_PX, (f32)width);
+    f32 y1 = MIN(ceilf(rect.y + rect.h) + DAMAGE_PAD_PX, (f32)height);
+
+    if (x1 <= x0 || y1 <= y0)
+        return (rectf){0};
+
+    return (rectf){x0, y0, x1 - x0, y1 - y0};
+}
+
+// Tells the caches of finished lines that lines inside rect joined or left the batch, and draws rect again
+void invalidate_caches(draw_tiles *tiles, draw_overview *overview, draw_reproject *reproject, frame_damage *damage, rectf rect)
+{
+    if (tiles != NULL)
+        draw_tiles_invalidate(tiles, rect);
+    if (overview != NULL)
+        draw_overview_invalidate(overview, rect);
+    if (reproject != NULL)
+        draw_reproject_invalidate(reproject, rect);
+    damage_add_world(damage, rect);
+}
+
 static const char *basic_vert = GLSL_SOURCE(
     330,
 
@@ -99,7 +236,7 @@ void mga_err(mga_error err)
 int main(void)
 {
     mga_desc desc = {
-        .desired_max_size = MGA_MiB(16),
+        .desired_max_size = MGA_GiB(1),
         .desired_block_size = MGA_KiB(256),
         .error_callback = mga_err};
     mg_arena *perm_arena = mga_create(&desc);
@@ -111,12 +248,23 @@ int main(void)
 
     u32 basic_program = glh_create_shader(basic_vert, basic_frag);
 
-    glUseProgram(basic_program);
+    glh_use_program(basic_program);
     u32 basic_view_mat_loc = glGetUniformLocation(basic_program, "u_view_mat");
     u32 basic_col_loc = glGetUniformLocation(basic_program, "u_col");
 
     draw_lines_shaders *shaders = draw_lines_shaders_create(perm_arena);
     draw_point_allocator *point_allocator = draw_point_alloc_create(perm_arena);
+    draw_index *line_index = draw_index_create(perm_arena);
+    // Finished lines get drawn from shared buffers, the stroke in progress draws on its own
+    draw_batch *line_batch = draw_batch_create(perm_arena);
+    // Points of the stroke in progress get uploaded once per frame
+    draw_stream *line_stream = draw_stream_create(perm_arena);
+    // Batched lines get drawn from textures that are only rendered again when lines join or leave the batch
+    draw_tiles *line_tiles = config.tile_cache ? draw_tiles_create(perm_arena, MAX_TILES) : NULL;
+    // Takes over from the tiles once the whole document is only a few pixels wide
+    draw_overview *line_overview = config.overview_screen_size > 0.0f ? draw_overview_create(perm_arena) : NULL;
+    // Only used without the tiles, which already make moving the view cheap
+    draw_reproject *line_reproject = config.reproject && !config.tile_cache ? draw_reproject_create(perm_arena) : NULL;
 
     /*u32 w = 500;
     u32 h = 400;
@@ -139,8 +287,8 @@ int main(void)
     }*/
 
     u32 num_lines = 0;
-    draw_lines *lines[1024] = {0};
-    undo_action undo_stack[1024];
+    draw_lines **lines = MGA_PUSH_ZERO_ARRAY(perm_arena, draw_lines *, MAX_LINES);
+    undo_action *undo_stack = MGA_PUSH_ZERO_ARRAY(perm_arena, undo_action, MAX_UNDO);
     u32 undo_count = 0;
 
     vec2f rect_verts[] = {
@@ -155,7 +303,7 @@ int main(void)
 
     u32 vertex_array = 0;
     glGenVertexArrays(1, &vertex_array);
-    glBindVertexArray(vertex_array);
+    glh_bind_vertex_array(vertex_array);
 
     u32 vertex_buffer = glh_create_buffer(GL_ARRAY_BUFFER, sizeof(rect_verts), rect_verts, GL_DYNAMIC_DRAW);
     u32 index_buffer = glh_create_buffer(GL_ELEMENT_ARRAY_BUFFER, sizeof(rect_indices), rect_indices, GL_STATIC_DRAW);
@@ -174,14 +322,20 @@ int main(void)
     mat3f_from_view(&view_mat, view);
     mat3f_inverse(&inv_view_mat, &view_mat);
 
-    gfx_win_process_events(win);
+    gfx_win_process_events(win, 0);
 
     vec2f prev_mouse_pos = win->mouse_pos;
     vec2f prev_point = prev_mouse_pos;
     vec2f prev_prev_point = prev_mouse_pos;
+    // World units per screen pixel when the current stroke was started
+    f32 stroke_pixel_size = 1.0f;
 
     b32 erase = false;
+    // Set while the last lines are the stroke being drawn, clicks on the UI do not start one
+    b32 stroking = false;
     b32 extending_point = false;
+    // The eraser covers the whole path from here to the mouse, so fast moves do not skip lines
+    vec2f prev_eraser_pos = prev_mouse_pos;
 
     f32 target_zoom_width = view.width;
     vec4f current_color = {config.default_color_r, config.default_color_g, config.default_color_b, 1.0f};
@@ -214,20 +368,42 @@ int main(void)
     rectf eraser_button = {start_x, start_y + eraser_pad + NUM_COLORS * (btn_size + btn_padding), btn_size, btn_size};
     rectf size_up_button = {start_x, start_y + eraser_pad + (NUM_COLORS + 1) * (btn_size + btn_padding), btn_size, btn_size};
     rectf size_down_button = {start_x, start_y + eraser_pad + (NUM_COLORS + 2) * (btn_size + btn_padding), btn_size, btn_size};
+    // All buttons with the border of the first one
+    rectf ui_rect = rectf_union(color_buttons[0], size_down_button);
+    ui_rect = (rectf){ui_rect.x - 2, ui_rect.y - 2, ui_rect.w + 4, ui_rect.h + 4};
+
+    frame_damage damage = {.full = true};
+    // Damage of the last frames, the last one first. Older back buffers miss those changes
+    rectf damage_history[MAX_DAMAGE_AGE] = {0};
+    viewf drawn_view = view;
+    u32 drawn_width = win->width;
+    u32 drawn_height = win->height;
+    rectf prev_cursor_rect = {0};
+    vec4f prev_cursor_color = {0};
+    // Set when the last frame showed the view somewhere else than the one before
+    b32 view_moved = false;
+    // Frames are only drawn after events while nothing moves
+    u32 wait_ms = 0;
 
     os_time_init();
 
     u64 prev_frame = os_now_usec();
     while (!win->should_close)
     {
-        u64 cur_frame = os_now_usec();
-        f32 delta = (f32)(cur_frame - prev_frame) / 1e6;
-        prev_frame = cur_frame;
+        // Counts the GL calls the state cache drops in this frame
+        glh_state_new_frame();
 
 #ifndef PLATFORM_WASM
-        gfx_win_process_events(win);
+        // Time spent waiting for events is not part of the frame
+        u64 wait_start = os_now_usec();
+        gfx_win_process_events(win, wait_ms);
+        prev_frame += os_now_usec() - wait_start;
 #endif
 
+        u64 cur_frame = os_now_usec();
+        f32 delta = MIN((f32)(cur_frame - prev_frame) / 1e6, MAX_FRAME_DELTA);
+        prev_frame = cur_frame;
+
         // Update
 
         f32 move_speed = view.width;
@@ -235,8 +411,12 @@ int main(void)
         view.aspect_ratio = (f32)win->width / win->height;
 
         // Smooth zoom
-        target_zoom_width *= 1.0f + (-config.zoom_speed * win->mouse_scroll * delta);
+        target_zoom_width *= 1.0f + (-config.zoom_speed * win->mouse_scroll * ZOOM_NOTCH_TIME);
         view.width += (target_zoom_width - view.width) * config.zoom_smoothness * delta;
+        if (fabsf(target_zoom_width - view.width) < view.width * ZOOM_SNAP)
+        {
+            view.width = target_zoom_width;
+        }
 
         if (GFX_IS_KEY_DOWN(win, GFX_KEY_W))
         {
@@ -272,12 +452,54 @@ int main(void)
                 undo_action *ua = &undo_stack[--undo_count];
                 if (ua->type == UNDO_DRAW && num_lines > 0)
                 {
+                    invalidate_caches(line_tiles, line_overview, line_reproject, &damage, lines[num_lines - 1]->bounding_box);
                     draw_lines_clear(lines[num_lines - 1]);
                     num_lines--;
+                    stroking = false;
                 }
                 else if (ua->type == UNDO_ERASE && ua->backup)
                 {
-                    lines[num_lines++] = ua->backup;
+                    for (u32 p = 0; p < ua->num_pieces; p++)
+                    {
+                        u32 j = 0;
+                        while (j < num_lines && lines[j] != ua->pieces[p])
+                        {
+                            j++;
+                        }
+                        if (j == num_lines)
+                        {
+                            continue;
+                        }
+
+                        draw_lines_destroy(ua->pieces[p]);
+
+                        num_lines--;
+                        for (; j < num_lines; j++)
+                        {
+                            lines[j] = lines[j + 1];
+                        }
+                        lines[num_lines] = NULL;
+                    }
+
+                    // Back into the slot it was erased from
+                    u32 i = MIN(ua->line_idx, num_lines);
+                    if (lines[num_lines] != NULL)
+                    {
+                        draw_lines_destroy(lines[num_lines]);
+                    }
+                    for (u32 j = num_lines; j > i; j--)
+                    {
+                        lines[j] = lines[j - 1];
+                    }
+                    num_lines++;
+
+                    lines[i] = ua->backup;
+                    draw_index_insert(line_index, ua->backup);
+                    draw_batch_add(line_batch, ua->backup);
+                    draw_batch_maybe_compact(line_batch, lines, num_lines);
+
+                    // The pieces are inside the box of the lines they were cut from
+                    invalidate_caches(line_tiles, line_overview, line_reproject, &damage, ua->backup->bounding_box);
                 }
             }
         }
@@ -329,31 +551,37 @@ int main(void)
 
         if (click_on_ui)
         {
+            damage_add_screen(&damage, ui_rect);
         }
         else if (GFX_IS_MOUSE_JUST_DOWN(win, GFX_MB_LEFT))
         {
             if (!erase)
             {
                 num_lines++;
+                stroking = true;
 
                 if (lines[num_lines - 1] == NULL)
                 {
                     lines[num_lines - 1] = draw_lines_create(perm_arena, point_allocator, current_color, brush_size);
+                    draw_index_insert(line_index, lines[num_lines - 1]);
                 }
                 else
                 {
                     draw_lines_reinit(lines[num_lines - 1], current_color, brush_size);
                 }
 
+                draw_stream_add(line_stream, lines[num_lines - 1]);
                 draw_lines_add_point(lines[num_lines - 1], mouse_pos);
+                damage_add_world(&damage, (rectf){mouse_pos.x - brush_size, mouse_pos.y - brush_size, brush_size * 2.0f, brush_size * 2.0f});
 
+                stroke_pixel_size = view.width / win->width;
                 prev_point = mouse_pos;
                 prev_prev_point = prev_point;
 
-                undo_stack[undo_count++] = (undo_action){UNDO_DRAW, num_lines - 1, NULL};
+                undo_stack[undo_count++] = (undo_action){UNDO_DRAW, num_lines - 1, NULL, NULL, 0};
             }
         }
-        else if (!erase && num_lines > 0 &&
+        else if (!erase && stroking && num_lines > 0 &&
                  (GFX_IS_MOUSE_DOWN(win, GFX_MB_LEFT) || GFX_IS_MOUSE_JUST_UP(win, GFX_MB_LEFT)) &&
                  !vec2f_eq(mouse_pos, prev_mouse_pos))
         {
@@ -374,259 +602,531 @@ int main(void)
                 f32 t_interval = 1.0f / (f32)(num_points + 1);
                 f32 t = t_interval;
 
+                mga_temp scratch = mga_scratch_get(NULL, 0);
+                vec2f *interp_points = MGA_PUSH_ARRAY(scratch.arena, vec2f, num_points);
+
                 for (u32 i = 0; i < num_points; i++)
                 {
                     vec2f p = c0;
                     p = vec2f_add(p, vec2f_scl(c1, t));
                     p = vec2f_add(p, vec2f_scl(c2, t * t));
 
-                    draw_lines_add_point(lines[num_lines - 1], p);
+                    interp_points[i] = p;
 
                     t += t_interval;
                 }
 
+                draw_lines_add_points(lines[num_lines - 1], interp_points, num_points);
+
+                // Only the end of the stroke changed, from the last point it had to the new ones
+                f32 line_width = lines[num_lines - 1]->width;
+                rectf changed = {prev_prev_point.x, prev_prev_point.y, 0.0f, 0.0f};
+                changed = rectf_union(changed, (rectf){prev_point.x, prev_point.y, 0.0f, 0.0f});
+                for (u32 i = 0; i < num_points; i++)
+                {
+                    changed = rectf_union(changed, (rectf){interp_points[i].x, interp_points[i].y, 0.0f, 0.0f});
+                }
+                damage_add_world(&damage, (rectf){changed.x - line_width, changed.y - line_width, changed.w + line_width * 2.0f, changed.h + line_width * 2.0f});
+
+                mga_scratch_release(scratch);
+
                 prev_prev_point = prev_point;
                 prev_point = mouse_pos;
             }
         }
         prev_mouse_pos = mouse_pos;
 
-        for (i64 i = 0; i < num_lines; i++)
+        // Finished strokes get simplified, then move to the compressed point storage
+        if (!erase && stroking && num_lines > 0 && GFX_IS_MOUSE_JUST_UP(win, GFX_MB_LEFT))
         {
-            if (erase && GFX_IS_MOUSE_DOWN(win, GFX_MB_LEFT) && draw_lines_collide_circle(lines[i], (circlef){mouse_pos, eraser_size}))
-            {
-                draw_lines *backup = draw_lines_clone(perm_arena, lines[i]);
-                undo_stack[undo_count++] = (undo_action){UNDO_ERASE, i, backup};
+            draw_lines *finished = lines[num_lines - 1];
+            stroking = false;
 
-                draw_lines_clear(lines[i]);
-                draw_lines *cleared_line = lines[i];
+            if (finished->stream != NULL)
+            {
+                draw_stream_remove(line_stream, finished);
+            }
 
-                num_lines--;
+            if (config.simplify_tolerance > 0.0f && !finished->points.sealed && finished->points.size > 2)
+            {
+                // Tolerance is in pixels at the zoom the stroke was drawn at
+                draw_lines *simplified = draw_lines_simplify(perm_arena, finished, config.simplify_tolerance * stroke_pixel_size);
 
-                for (i64 j = i; j < num_lines; j++)
+                if (simplified != NULL)
                 {
-                    lines[j] = lines[j + 1];
-                }
-                lines[num_lines] = cleared_line;
+                    draw_lines_destroy(finished);
+                    draw_index_insert(line_index, simplified);
 
-                i--;
+                    lines[num_lines - 1] = simplified;
+                    finished = simplified;
+                }
             }
-        }
 
-        gfx_win_clear(win);
+            draw_batch_add(line_batch, finished);
+            draw_lines_seal(finished);
 
-        // Draw
+            invalidate_caches(line_tiles, line_overview, line_reproject, &damage, finished->bounding_box);
+        }
 
-        // Rect draw (Canvas)
+        if (GFX_IS_MOUSE_JUST_DOWN(win, GFX_MB_LEFT))
+        {
+            prev_eraser_pos = mouse_pos;
+        }
+
+        if (erase && GFX_IS_MOUSE_DOWN(win, GFX_MB_LEFT) && num_lines > 0)
         {
-            glUseProgram(basic_program);
-            glUniformMatrix3fv(basic_view_mat_loc, 1, GL_FALSE, view_mat.m);
+            capsulef eraser = {prev_eraser_pos, mouse_pos, eraser_size};
+
+            // Only the lines sharing grid cells with the eraser get tested
+            mga_temp scratch = mga_scratch_get(NULL, 0);
+            draw_lines **candidates = MGA_PUSH_ARRAY(scratch.arena, draw_lines *, num_lines);
+            u32 num_candidates = draw_index_query_capsule(line_index, eraser, candidates, num_lines);
+
+            for (u32 c = 0; c < num_candidates; c++)
+            {
+                if (!draw_lines_collide_capsule(candidates[c], eraser))
+                {
+                    continue;
+                }
+
+                u32 i = 0;
+                while (i < num_lines && lines[i] != candidates[c])
+                {
+                    i++;
+                }
+                if (i == num_lines)
+                {
+                    continue;
+                }
+
+                if (undo_count >= MAX_UNDO)
+                {
+                    continue;
+                }
+
+                // Only the hit segments go away, the rest stays as separate lines
+                draw_lines **pieces = MGA_PUSH_ARRAY(scratch.arena, draw_lines *, lines[i]->points.size / 2 + 1);
+                u32 num_pieces = 0;
+                if (!draw_lines_split_capsule(perm_arena, lines[i], eraser, pieces, &num_pieces))
+                {
+                    continue;
+                }
+
+                // Undoing an erase needs a free slot past the last line
+                if (num_pieces > 1 && num_lines + num_pieces - 1 >= MAX_LINES)
+                {
+                    for (u32 p = 0; p < num_pieces; p++)
+                    {
+                        draw_lines_destroy(pieces[p]);
+                    }
+                    continue;
+                }
+
+                // The erased lines are kept as they are for undo
+                draw_lines *erased = lines[i];
+                draw_index_remove(line_index, erased);
+                if (erased->batch != NULL)
+                {
+                    draw_batch_remove(line_batch, erased);
+                }
+                invalidate_caches(line_tiles, line_overview, line_reproject, &damage, erased->bounding_box);
 
-            glUniform4f(basic_col_loc, 1.0f, 1.0f, 1.0f, 1.0f); // White canvas
+                undo_action ua = {UNDO_ERASE, i, erased, NULL, num_pieces};
+                if (num_pieces > 0)
+                {
+                    ua.pieces = MGA_PUSH_ARRAY(perm_arena, draw_lines *, num_pieces);
+                    memcpy(ua.pieces, pieces, sizeof(draw_lines *) * num_pieces);
+                }
+                undo_stack[undo_count++] = ua;
 
-            glBindVertexArray(vertex_array);
-            glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+                for (u32 p = 0; p < num_pieces; p++)
+                {
+                    draw_index_insert(line_index, pieces[p]);
+                }
 
-            // A4 Ratio approx (210x297) scaled up
-            f32 cw = 210.0f * 4.0f;
-            f32 ch = 297.0f * 4.0f;
-            vec2f canvas_verts[] = {
-                {-cw / 2, ch / 2},
-                {-cw / 2, -ch / 2},
-                {cw / 2, -ch / 2},
-                {cw / 2, ch / 2}};
+                if (num_pieces == 0)
+                {
+                    num_lines--;
+                    for (u32 j = i; j < num_lines; j++)
+                    {
+                        lines[j] = lines[j + 1];
+                    }
+                    lines[num_lines] = NULL;
+                }
+                else
+                {
+                    // Spare lines past the end get overwritten by the shift
+                    u32 shift = num_pieces - 1;
+                    for (u32 j = num_lines; j < num_lines + shift; j++)
+                    {
+                        if (lines[j] != NULL)
+                        {
+                            draw_lines_destroy(lines[j]);
+                        }
+                    }
+                    for (u32 j = num_lines - 1; j > i; j--)
+                    {
+                        lines[j + shift] = lines[j];
+                    }
+                    num_lines += shift;
+
+                    for (u32 p = 0; p < num_pieces; p++)
+                    {
+                        lines[i + p] = pieces[p];
+                    }
+                }
+            }
 
-            glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(canvas_verts), canvas_verts);
+            mga_scratch_release(scratch);
+        }
+        prev_eraser_pos = mouse_pos;
 
-            glEnableVertexAttribArray(0);
-            glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(vec2f), NULL);
+        // Pieces stay unsealed and unbatched while erasing, so that cutting them again does not redo that work every frame
+        if (erase && GFX_IS_MOUSE_JUST_UP(win, GFX_MB_LEFT))
+        {
+            for (u32 i = 0; i < num_lines; i++)
+            {
+                if (lines[i]->batch == NULL)
+                {
+                    draw_batch_add(line_batch, lines[i]);
+
+                    // Tiles rendered while erasing did not have the pieces yet
+                    invalidate_caches(line_tiles, line_overview, line_reproject, &damage, lines[i]->bounding_box);
+                }
+                if (!lines[i]->points.sealed)
+                {
+                    draw_lines_seal(lines[i]);
+                }
+            }
+
+            draw_batch_maybe_compact(line_batch, lines, num_lines);
+        }
 
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer);
-            glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, NULL);
+        // Damage
 
-            glDisableVertexAttribArray(0);
+        f32 cursor_size = erase ? eraser_size : brush_size;
+        // The cursor is drawn around the mouse in world units
+        f32 cursor_px = cursor_size * win->width / view.width;
+        rectf cursor_rect = {win->mouse_pos.x - cursor_px, win->mouse_pos.y - cursor_px, cursor_px * 2.0f, cursor_px * 2.0f};
+        vec4f cursor_color = erase ? (vec4f){1.0f, 0.4f, 0.7f, 0.6f} : (vec4f){current_color.x, current_color.y, current_color.z, 0.6f};
+        if (memcmp(&cursor_rect, &prev_cursor_rect, sizeof(rectf)) != 0 || memcmp(&cursor_color, &prev_cursor_color, sizeof(vec4f)) != 0)
+        {
+            damage_add_screen(&damage, prev_cursor_rect);
+            damage_add_screen(&damage, cursor_rect);
         }
+        prev_cursor_rect = cursor_rect;
+        prev_cursor_color = cursor_color;
 
-        for (u32 i = 0; i < num_lines; i++)
+        b32 view_changed = memcmp(&view, &drawn_view, sizeof(viewf)) != 0;
+        if (win->exposed || win->width != drawn_width || win->height != drawn_height || view_changed)
+        {
+            damage.full = true;
+        }
+        // The reprojected frame gets drawn exactly once the view stops
+        if (line_reproject != NULL && view_moved && !view_changed)
+        {
+            damage.full = true;
+        }
+        if (!config.partial_redraw && (damage.has_world || damage.has_screen))
         {
-            draw_lines_draw(lines[i], shaders, win, view);
+            damage.full = true;
         }
+        view_moved = view_changed;
+
+        rectf win_rect = {0.0f, 0.0f, (f32)win->width, (f32)win->height};
+        rectf changed_rect = damage_screen_rect(&damage, &view_mat, win->width, win->height);
+        damage = (frame_damage){0};
 
+        // Nothing changed, the last frame stays on the screen
+        b32 redraw = changed_rect.w > 0.0f && changed_rect.h > 0.0f;
+
+        // The back buffer also misses what changed in the frames since it was drawn
+        rectf redraw_rect = changed_rect;
+        u32 buffer_age = redraw ? gfx_win_buffer_age(win) : 0;
+        if (buffer_age == 0 || buffer_age > MAX_DAMAGE_AGE)
+        {
+            redraw_rect = win_rect;
+        }
+        else
         {
-            glUseProgram(basic_program);
+            for (u32 i = 0; i + 1 < buffer_age; i++)
+            {
+                redraw_rect = damage_union(redraw_rect, damage_history[i]);
+            }
+        }
+        b32 redraw_all = redraw_rect.w >= win_rect.w && redraw_rect.h >= win_rect.h;
 
-            mat3f ui_mat = {0};
-            ui_mat.m[0] = 2.0f / win->width;
-            ui_mat.m[4] = -2.0f / win->height;
-            ui_mat.m[8] = 1.0f;
-            ui_mat.m[6] = -1.0f;
-            ui_mat.m[7] = 1.0f;
+        if (redraw)
+        {
+            if (!redraw_all)
+            {
+                glEnable(GL_SCISSOR_TEST);
+                glScissor((i32)redraw_rect.x, (i32)(win->height - redraw_rect.y - redraw_rect.h), (i32)redraw_rect.w, (i32)redraw_rect.h);
+            }
 
-            glUniformMatrix3fv(basic_view_mat_loc, 1, GL_FALSE, ui_mat.m);
+            gfx_win_clear(win);
 
-            glBindVertexArray(vertex_array);
-            glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer);
+            // Draw
 
-            for (int i = 0; i < NUM_COLORS; i++)
+            // Rect draw (Canvas)
             {
-                vec4f col = colors[i];
-
-                if (i == 0)
-                {
-                    glUniform4f(basic_col_loc, 0.3f, 0.3f, 0.3f, 1.0f);
-                    rectf br = {color_buttons[i].x - 2, color_buttons[i].y - 2, color_buttons[i].w + 4, color_buttons[i].h + 4};
-                    vec2f bverts[] = {
-                        {br.x, br.y},
-                        {br.x, br.y + br.h},
-                        {br.x + br.w, br.y + br.h},
-                        {br.x + br.w, br.y}};
-                    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(bverts), bverts);
-                    glEnableVertexAttribArray(0);
-                    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(vec2f), NULL);
-                    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, NULL);
-                }
+                glh_use_program(basic_program);
+                glUniformMatrix3fv(basic_view_mat_loc, 1, GL_FALSE, view_mat.m);
+
+                glUniform4f(basic_col_loc, 1.0f, 1.0f, 1.0f, 1.0f); // White canvas
 
-                glUniform4f(basic_col_loc, col.x, col.y, col.z, col.w);
+                glh_bind_vertex_array(vertex_array);
+                glh_bind_buffer(GL_ARRAY_BUFFER, vertex_buffer);
 
-                rectf r = color_buttons[i];
-                vec2f verts[] = {
-                    {r.x, r.y},
-                    {r.x, r.y + r.h},
-                    {r.x + r.w, r.y + r.h},
-                    {r.x + r.w, r.y}};
+                // A4 Ratio approx (210x297) scaled up
+                f32 cw = 210.0f * 4.0f;
+                f32 ch = 297.0f * 4.0f;
+                vec2f canvas_verts[] = {
+                    {-cw / 2, ch / 2},
+                    {-cw / 2, -ch / 2},
+                    {cw / 2, -ch / 2},
+                    {cw / 2, ch / 2}};
 
-                glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(verts), verts);
+                glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(canvas_verts), canvas_verts);
 
                 glEnableVertexAttribArray(0);
                 glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(vec2f), NULL);
 
+                glh_bind_buffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer);
                 glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, NULL);
-            }
 
-            glUniform4f(basic_col_loc, 1.0f, 0.4f, 0.7f, 1.0f);
-            {
-                rectf r = eraser_button;
-                vec2f verts[] = {
-                    {r.x, r.y},
-                    {r.x, r.y + r.h},
-                    {r.x + r.w, r.y + r.h},
-                    {r.x + r.w, r.y}};
-                glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(verts), verts);
-                glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, NULL);
+                glDisableVertexAttribArray(0);
             }
 
-            glUniform4f(basic_col_loc, 0.5f, 0.5f, 0.5f, 1.0f);
+            draw_stream_flush(line_stream);
             {
-                rectf r = size_up_button;
-                vec2f verts[] = {
-                    {r.x, r.y},
-                    {r.x, r.y + r.h},
-                    {r.x + r.w, r.y + r.h},
-                    {r.x + r.w, r.y}};
-                glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(verts), verts);
-                glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, NULL);
+                // Partial redraws only draw the lines in a viewport around the redrawn rect, so the rest gets culled.
+                // The reprojected frame is window sized and only gets cut by the scissor rect
+                viewf region_view = view;
+                gfx_window region_win = {.width = win->width, .height = win->height};
 
-                glUniform4f(basic_col_loc, 1.0f, 1.0f, 1.0f, 1.0f);
-                f32 cx = r.x + r.w / 2;
-                f32 cy = r.y + r.h / 2;
-                vec2f plus_h[] = {{cx - 8, cy - 2}, {cx - 8, cy + 2}, {cx + 8, cy + 2}, {cx + 8, cy - 2}};
-                glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(plus_h), plus_h);
-                glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, NULL);
-                vec2f plus_v[] = {{cx - 2, cy - 8}, {cx - 2, cy + 8}, {cx + 2, cy + 8}, {cx + 2, cy - 8}};
-                glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(plus_v), plus_v);
-                glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, NULL);
-            }
+                if (!redraw_all && line_reproject == NULL)
+                {
+                    vec2f region_center = {
+                        2.0f * (redraw_rect.x + redraw_rect.w * 0.5f) / win->width - 1.0f,
+                        -(2.0f * (redraw_rect.y + redraw_rect.h * 0.5f) / win->height - 1.0f),
+                    };
 
-            glUniform4f(basic_col_loc, 0.5f, 0.5f, 0.5f, 1.0f);
-            {
-                rectf r = size_down_button;
-                vec2f verts[] = {
-                    {r.x, r.y},
-                    {r.x, r.y + r.h},
-                    {r.x + r.w, r.y + r.h},
-                    {r.x + r.w, r.y}};
-                glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(verts), verts);
-                glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, NULL);
+                    region_view.center = viewf_ndc_to_world(view, region_center);
+                    region_view.aspect_ratio = redraw_rect.w / redraw_rect.h;
+                    region_view.width = view.width * redraw_rect.w / win->width;
+                    region_win = (gfx_window){.width = (u32)redraw_rect.w, .height = (u32)redraw_rect.h};
 
-                glUniform4f(basic_col_loc, 1.0f, 1.0f, 1.0f, 1.0f);
-                f32 cx = r.x + r.w / 2;
-                f32 cy = r.y + r.h / 2;
-                vec2f minus_h[] = {{cx - 8, cy - 2}, {cx - 8, cy + 2}, {cx + 8, cy + 2}, {cx + 8, cy - 2}};
-                glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(minus_h), minus_h);
-                glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, NULL);
-            }
+                    glViewport((i32)redraw_rect.x, (i32)(win->height - redraw_rect.y - redraw_rect.h), region_win.width, region_win.height);
+                }
 
-            if (!eraser_mode)
-            {
-                glUniform4f(basic_col_loc, 1.0f, 1.0f, 1.0f, 1.0f);
-                rectf r = color_buttons[color_idx];
-                vec2f center = {r.x + r.w / 2, r.y + r.h / 2};
-                f32 s = 5.0f;
-                vec2f dot_verts[] = {
-                    {center.x - s, center.y - s},
-                    {center.x - s, center.y + s},
-                    {center.x + s, center.y + s},
-                    {center.x + s, center.y - s}};
-                glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(dot_verts), dot_verts);
-                glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, NULL);
+                if (line_overview != NULL &&
+                    draw_overview_draw(line_overview, line_batch, lines, num_lines, shaders, &region_win, region_view, config.overview_screen_size))
+                {
+                }
+                else if (line_tiles != NULL)
+                {
+                    draw_tiles_draw(line_tiles, line_batch, lines, num_lines, shaders, &region_win, region_view);
+                }
+                else if (line_reproject != NULL)
+                {
+                    draw_reproject_draw(line_reproject, line_batch, lines, num_lines, shaders, win, view);
+                }
+                else
+                {
+                    draw_batch_draw(line_batch, lines, num_lines, shaders, &region_win, region_view);
+                }
+
+                glViewport(0, 0, win->width, win->height);
             }
-            else
+
             {
-                glUniform4f(basic_col_loc, 1.0f, 1.0f, 1.0f, 1.0f);
-                rectf r = eraser_button;
-                vec2f center = {r.x + r.w / 2, r.y + r.h / 2};
-                f32 s = 5.0f;
-                vec2f dot_verts[] = {
-                    {center.x - s, center.y - s},
-                    {center.x - s, center.y + s},
-                    {center.x + s, center.y + s},
-                    {center.x + s, center.y - s}};
-                glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(dot_verts), dot_verts);
-                glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, NULL);
-            }
+                glh_use_program(basic_program);
 
-            glDisableVertexAttribArray(0);
-        }
+                mat3f ui_mat = {0};
+                ui_mat.m[0] = 2.0f / win->width;
+                ui_mat.m[4] = -2.0f / win->height;
+                ui_mat.m[8] = 1.0f;
+                ui_mat.m[6] = -1.0f;
+                ui_mat.m[7] = 1.0f;
 
-        {
-            glUseProgram(basic_program);
-            glUniformMatrix3fv(basic_view_mat_loc, 1, GL_FALSE, view_mat.m);
-            glBindVertexArray(vertex_array);
-            glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer);
+                glUniformMatrix3fv(basic_view_mat_loc, 1, GL_FALSE, ui_mat.m);
 
-            f32 cursor_size = erase ? eraser_size : brush_size;
-            vec4f cursor_color = erase ? (vec4f){1.0f, 0.4f, 0.7f, 0.6f} : (vec4f){current_color.x, current_color.y, current_color.z, 0.6f};
+                glh_bind_vertex_array(vertex_array);
+                glh_bind_buffer(GL_ARRAY_BUFFER, vertex_buffer);
+                glh_bind_buffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer);
 
-            glUniform4f(basic_col_loc, cursor_color.x, cursor_color.y, cursor_color.z, cursor_color.w);
+                for (int i = 0; i < NUM_COLORS; i++)
+                {
+                    vec4f col = colors[i];
+
+                    if (i == 0)
+                    {
+                        glUniform4f(basic_col_loc, 0.3f, 0.3f, 0.3f, 1.0f);
+                        rectf br = {color_buttons[i].x - 2, color_buttons[i].y - 2, color_buttons[i].w + 4, color_buttons[i].h + 4};
+                        vec2f bverts[] = {
+                            {br.x, br.y},
+                            {br.x, br.y + br.h},
+                            {br.x + br.w, br.y + br.h},
+                            {br.x + br.w, br.y}};
+                        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(bverts), bverts);
+                        glEnableVertexAttribArray(0);
+                        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(vec2f), NULL);
+                        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, NULL);
+                    }
+
+                    glUniform4f(basic_col_loc, col.x, col.y, col.z, col.w);
+
+                    rectf r = color_buttons[i];
+                    vec2f verts[] = {
+                        {r.x, r.y},
+                        {r.x, r.y + r.h},
+                        {r.x + r.w, r.y + r.h},
+                        {r.x + r.w, r.y}};
+
+                    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(verts), verts);
+
+                    glEnableVertexAttribArray(0);
+                    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(vec2f), NULL);
+
+                    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, NULL);
+                }
+
+                glUniform4f(basic_col_loc, 1.0f, 0.4f, 0.7f, 1.0f);
+                {
+                    rectf r = eraser_button;
+                    vec2f verts[] = {
+                        {r.x, r.y},
+                        {r.x, r.y + r.h},
+                        {r.x + r.w, r.y + r.h},
+                        {r.x + r.w, r.y}};
+                    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(verts), verts);
+                    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, NULL);
+                }
+
+                glUniform4f(basic_col_loc, 0.5f, 0.5f, 0.5f, 1.0f);
+                {
+                    rectf r = size_up_button;
+                    vec2f verts[] = {
+                        {r.x, r.y},
+                        {r.x, r.y + r.h},
+                        {r.x + r.w, r.y + r.h},
+                        {r.x + r.w, r.y}};
+                    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(verts), verts);
+                    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, NULL);
+
+                    glUniform4f(basic_col_loc, 1.0f, 1.0f, 1.0f, 1.0f);
+                    f32 cx = r.x + r.w / 2;
+                    f32 cy = r.y + r.h / 2;
+                    vec2f plus_h[] = {{cx - 8, cy - 2}, {cx - 8, cy + 2}, {cx + 8, cy + 2}, {cx + 8, cy - 2}};
+                    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(plus_h), plus_h);
+                    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, NULL);
+                    vec2f plus_v[] = {{cx - 2, cy - 8}, {cx - 2, cy + 8}, {cx + 2, cy + 8}, {cx + 2, cy - 8}};
+                    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(plus_v), plus_v);
+                    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, NULL);
+                }
+
+                glUniform4f(basic_col_loc, 0.5f, 0.5f, 0.5f, 1.0f);
+                {
+                    rectf r = size_down_button;
+                    vec2f verts[] = {
+                        {r.x, r.y},
+                        {r.x, r.y + r.h},
+                        {r.x + r.w, r.y + r.h},
+                        {r.x + r.w, r.y}};
+                    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(verts), verts);
+                    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, NULL);
+
+                    glUniform4f(basic_col_loc, 1.0f, 1.0f, 1.0f, 1.0f);
+                    f32 cx = r.x + r.w / 2;
+                    f32 cy = r.y + r.h / 2;
+                    vec2f minus_h[] = {{cx - 8, cy - 2}, {cx - 8, cy + 2}, {cx + 8, cy + 2}, {cx + 8, cy - 2}};
+                    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(minus_h), minus_h);
+                    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, NULL);
+                }
+
+                if (!eraser_mode)
+                {
+                    glUniform4f(basic_col_loc, 1.0f, 1.0f, 1.0f, 1.0f);
+                    rectf r = color_buttons[color_idx];
+                    vec2f center = {r.x + r.w / 2, r.y + r.h / 2};
+                    f32 s = 5.0f;
+                    vec2f dot_verts[] = {
+                        {center.x - s, center.y - s},
+                        {center.x - s, center.y + s},
+                        {center.x + s, center.y + s},
+                        {center.x + s, center.y - s}};
+                    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(dot_verts), dot_verts);
+                    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, NULL);
+                }
+                else
+                {
+                    glUniform4f(basic_col_loc, 1.0f, 1.0f, 1.0f, 1.0f);
+                    rectf r = eraser_button;
+                    vec2f center = {r.x + r.w / 2, r.y + r.h / 2};
+                    f32 s = 5.0f;
+                    vec2f dot_verts[] = {
+                        {center.x - s, center.y - s},
+                        {center.x - s, center.y + s},
+                        {center.x + s, center.y + s},
+                        {center.x + s, center.y - s}};
+                    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(dot_verts), dot_verts);
+                    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, NULL);
+                }
+
+                glDisableVertexAttribArray(0);
+            }
 
-            int segments = 32;
-            for (int seg = 0; seg < segments; seg++)
             {
-                f32 angle1 = (f32)seg / segments * 6.28318f;
-                f32 angle2 = (f32)(seg + 1) / segments * 6.28318f;
-                vec2f p0 = mouse_pos;
-                vec2f p1 = {mouse_pos.x + cosf(angle1) * cursor_size, mouse_pos.y + sinf(angle1) * cursor_size};
-                vec2f p2 = {mouse_pos.x + cosf(angle2) * cursor_size, mouse_pos.y + sinf(angle2) * cursor_size};
-
-                vec2f tri_verts[] = {p0, p1, p2, p0};
-                glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(tri_verts), tri_verts);
-                glEnableVertexAttribArray(0);
-                glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(vec2f), NULL);
-                glDrawArrays(GL_TRIANGLES, 0, 3);
+                glh_use_program(basic_program);
+                glUniformMatrix3fv(basic_view_mat_loc, 1, GL_FALSE, view_mat.m);
+                glh_bind_vertex_array(vertex_array);
+                glh_bind_buffer(GL_ARRAY_BUFFER, vertex_buffer);
+                glh_bind_buffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer);
+
+                glUniform4f(basic_col_loc, cursor_color.x, cursor_color.y, cursor_color.z, cursor_color.w);
+
+                int segments = 32;
+                for (int seg = 0; seg < segments; seg++)
+                {
+                    f32 angle1 = (f32)seg / segments * 6.28318f;
+                    f32 angle2 = (f32)(seg + 1) / segments * 6.28318f;
+                    vec2f p0 = mouse_pos;
+                    vec2f p1 = {mouse_pos.x + cosf(angle1) * cursor_size, mouse_pos.y + sinf(angle1) * cursor_size};
+                    vec2f p2 = {mouse_pos.x + cosf(angle2) * cursor_size, mouse_pos.y + sinf(angle2) * cursor_size};
+
+                    vec2f tri_verts[] = {p0, p1, p2, p0};
+                    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(tri_verts), tri_verts);
+                    glEnableVertexAttribArray(0);
+                    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(vec2f), NULL);
+                    glDrawArrays(GL_TRIANGLES, 0, 3);
+                }
+
+                glDisableVertexAttribArray(0);
             }
 
-            glDisableVertexAttribArray(0);
+            glDisable(GL_SCISSOR_TEST);
+
+            gfx_win_swap_buffers_damage(win, changed_rect);
+
+            memmove(damage_history + 1, damage_history, sizeof(rectf) * (MAX_DAMAGE_AGE - 1));
+            damage_history[0] = changed_rect;
+            drawn_view = view;
+            drawn_width = win->width;
+            drawn_height = win->height;
         }
 
-        gfx_win_swap_buffers(win);
+        // Frames keep coming while the view moves, otherwise the next one waits for input
+        b32 animating = view_moved || view.width != target_zoom_width ||
+                        GFX_IS_KEY_DOWN(win, GFX_KEY_W) || GFX_IS_KEY_DOWN(win, GFX_KEY_S) ||
+                        GFX_IS_KEY_DOWN(win, GFX_KEY_A) || GFX_IS_KEY_DOWN(win, GFX_KEY_D);
+        wait_ms = animating ? 0 : IDLE_WAIT_MS;
 
 #ifdef PLATFORM_WASM
-        gfx_win_process_events(win);
+        u64 wait_start = os_now_usec();
+        gfx_win_process_events(win, wait_ms);
+        prev_frame += os_now_usec() - wait_start;
 #endif
-
-        os_sleep_ms(2);
     }
 
     for (u32 i = 0; i < num_lines; i++)
@@ -634,14 +1134,28 @@ int main(void)
         draw_lines_destroy(lines[i]);
     }
 
+    if (line_reproject != NULL)
+    {
+        draw_reproject_destroy(line_reproject);
+    }
+    if (line_overview != NULL)
+    {
+        draw_overview_destroy(line_overview);
+    }
+    if (line_tiles != NULL)
+    {
+        draw_tiles_destroy(line_tiles);
+    }
+    draw_batch_destroy(line_batch);
+    draw_stream_destroy(line_stream);
     draw_lines_shaders_destroy(shaders);
     draw_point_alloc_destroy(point_allocator);
 
-    glDeleteBuffers(1, &vertex_buffer);
-    glDeleteBuffers(1, &index_buffer);
-    glDeleteVertexArrays(1, &vertex_array);
+    glh_delete_buffers(1, &vertex_buffer);
+    glh_delete_buffers(1, &index_buffer);
+    glh_delete_vertex_arrays(1, &vertex_array);
 
-    glDeleteProgram(basic_program);
+    glh_delete_program(basic_program);
 
     gfx_win_destroy(win);
 